@@ -0,0 +1,207 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "harness.h"
+#include "hugepage.h"
+
+/* Chunk growth: start at 64 KiB, double on every refill up to 2 MiB */
+#define ARENA_MIN_CHUNK (64 * 1024)
+#define ARENA_MAX_CHUNK (2 * 1024 * 1024)
+
+/* Round size up to the arena granularity */
+#define ARENA_ROUND(size) (((size) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+/* Bin of a larger object of size bytes */
+#define ARENA_BIN(size) (8 * sizeof(size_t) - 1 - __builtin_clzl(size))
+
+/* Blocks of a bin tried for a fit before moving to the bins above it */
+#define ARENA_BIN_SCAN 8
+
+/* Allocate a chunk able to hold at least size bytes and bump from it */
+static bool arena_refill(arena_t *a, size_t size)
+{
+    size_t bytes = a->chunk_size;
+    if (bytes < sizeof(arena_chunk_t) + size)
+        bytes = sizeof(arena_chunk_t) + size;
+
+    bool huge = huge_pages && bytes >= HUGE_MIN_CHUNK;
+    arena_chunk_t *chunk;
+    if (huge) {
+        bytes = HUGE_ROUND(bytes);
+        chunk = huge_alloc(bytes);
+    } else {
+        chunk = malloc(bytes);
+    }
+    if (!chunk)
+        return false;
+
+    if (!a->chunks)
+        a->oldest = chunk;
+    chunk->next = a->chunks;
+    chunk->mapped = huge ? bytes : 0;
+    a->chunks = chunk;
+    a->cursor = (char *) (chunk + 1);
+    a->limit = (char *) chunk + bytes;
+
+    if (a->chunk_size < ARENA_MAX_CHUNK)
+        a->chunk_size <<= 1;
+    return true;
+}
+
+bool arena_init(arena_t *a)
+{
+    a->chunks = NULL;
+    a->oldest = NULL;
+    a->chunk_size = ARENA_MIN_CHUNK;
+    a->cursor = NULL;
+    a->limit = NULL;
+    memset(a->freelist, 0, sizeof(a->freelist));
+    memset(a->bins, 0, sizeof(a->bins));
+
+    /* Have the first chunk ready, like pool_init() does */
+    return arena_refill(a, 0);
+}
+
+/* File an object of size bytes, already rounded, for reuse */
+static void arena_put(arena_t *a, void *obj, size_t size)
+{
+    if (size <= ARENA_MAX_RECYCLED) {
+        size_t c = size / ARENA_ALIGN - 1;
+        arena_slot_t *slot = obj;
+        if (!a->freelist[c])
+            a->freelist_last[c] = slot;
+        slot->next = a->freelist[c];
+        a->freelist[c] = slot;
+        return;
+    }
+
+    size_t i = ARENA_BIN(size);
+    arena_block_t *block = obj;
+    if (!a->bins[i])
+        a->bins_last[i] = block;
+    block->size = size;
+    block->next = a->bins[i];
+    a->bins[i] = block;
+}
+
+/*
+ * Take a larger object of at least size bytes from the bins, giving back
+ * what it has beyond size.  The bin of size may hold smaller objects, so
+ * only its first few are tried, while any object of the bins above fits.
+ */
+static void *arena_take_large(arena_t *a, size_t size)
+{
+    size_t i = ARENA_BIN(size);
+    arena_block_t **link = &a->bins[i];
+
+    for (int n = 0; *link && (*link)->size < size && n < ARENA_BIN_SCAN; n++)
+        link = &(*link)->next;
+    if (!*link || (*link)->size < size) {
+        for (link = NULL; !link && ++i < ARENA_BINS;) {
+            if (a->bins[i])
+                link = &a->bins[i];
+        }
+        if (!link)
+            return NULL;
+    }
+
+    arena_block_t *block = *link;
+    *link = block->next;
+    /* A link other than the head of the bin is the block before */
+    if (block == a->bins_last[i])
+        a->bins_last[i] = link == &a->bins[i] ? NULL : (arena_block_t *) link;
+    if (block->size > size)
+        arena_put(a, (char *) block + size, block->size - size);
+    return block;
+}
+
+void *arena_alloc(arena_t *a, size_t size)
+{
+    size = ARENA_ROUND(size);
+
+    if (size <= ARENA_MAX_RECYCLED) {
+        arena_slot_t **list = &a->freelist[size / ARENA_ALIGN - 1];
+        if (*list) {
+            arena_slot_t *slot = *list;
+            *list = slot->next;
+            return slot;
+        }
+    } else {
+        void *obj = arena_take_large(a, size);
+        if (obj)
+            return obj;
+    }
+
+    if ((size_t) (a->limit - a->cursor) < size && !arena_refill(a, size))
+        return NULL;
+
+    void *obj = a->cursor;
+    a->cursor += size;
+    return obj;
+}
+
+void arena_free(arena_t *a, void *obj, size_t size)
+{
+    arena_put(a, obj, ARENA_ROUND(size));
+}
+
+void arena_merge(arena_t *dst, arena_t *src)
+{
+    if (!src->chunks)
+        return;
+
+    src->oldest->next = dst->chunks;
+    if (!dst->chunks)
+        dst->oldest = src->oldest;
+    dst->chunks = src->chunks;
+
+    for (size_t c = 0; c < ARENA_CLASSES; c++) {
+        if (!src->freelist[c])
+            continue;
+        src->freelist_last[c]->next = dst->freelist[c];
+        if (!dst->freelist[c])
+            dst->freelist_last[c] = src->freelist_last[c];
+        dst->freelist[c] = src->freelist[c];
+    }
+    for (size_t i = 0; i < ARENA_BINS; i++) {
+        if (!src->bins[i])
+            continue;
+        src->bins_last[i]->next = dst->bins[i];
+        if (!dst->bins[i])
+            dst->bins_last[i] = src->bins_last[i];
+        dst->bins[i] = src->bins[i];
+    }
+
+    /* Only one chunk can be bumped from, keep the one with more room */
+    if (src->limit - src->cursor > dst->limit - dst->cursor) {
+        dst->cursor = src->cursor;
+        dst->limit = src->limit;
+    }
+    if (src->chunk_size > dst->chunk_size)
+        dst->chunk_size = src->chunk_size;
+
+    src->chunks = NULL;
+    src->oldest = NULL;
+    src->cursor = NULL;
+    src->limit = NULL;
+    memset(src->freelist, 0, sizeof(src->freelist));
+    memset(src->bins, 0, sizeof(src->bins));
+}
+
+void arena_destroy(arena_t *a)
+{
+    while (a->chunks) {
+        arena_chunk_t *next = a->chunks->next;
+        if (a->chunks->mapped)
+            huge_free(a->chunks, a->chunks->mapped);
+        else
+            free(a->chunks);
+        a->chunks = next;
+    }
+    a->oldest = NULL;
+    a->cursor = NULL;
+    a->limit = NULL;
+    memset(a->freelist, 0, sizeof(a->freelist));
+    memset(a->bins, 0, sizeof(a->bins));
+}
@@ -0,0 +1,84 @@
+#ifndef LAB0_ARENA_H
+#define LAB0_ARENA_H
+
+/*
+ * Bump allocator for variable-sized objects.
+ *
+ * Objects are carved one after the other out of large chunks obtained from
+ * malloc, or mapped as huge regions when huge_pages is set (see hugepage.h),
+ * and all of them go away at once with arena_destroy().  Small
+ * objects given back with arena_free() are kept on freelists sorted by
+ * size class, and reused by later allocations of the same class.  Larger
+ * ones go to bins by power of two, and are split to fit later allocations.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Granularity of object sizes, and of the freelist classes */
+#define ARENA_ALIGN sizeof(void *)
+
+/* Objects up to this size are recycled through the freelists */
+#define ARENA_MAX_RECYCLED 128
+
+#define ARENA_CLASSES (ARENA_MAX_RECYCLED / ARENA_ALIGN)
+
+/* Bin i holds larger objects of 2^i up to 2^(i+1) - 1 bytes */
+#define ARENA_BINS (8 * sizeof(size_t))
+
+/* Header placed in front of every chunk owned by an arena */
+typedef struct ARENA_CHUNK {
+    struct ARENA_CHUNK *next;
+    size_t mapped; /* Bytes of the huge region holding it, 0 if malloc'd */
+} arena_chunk_t;
+
+/* Object on a freelist, overlaid on the released object itself */
+typedef struct ARENA_SLOT {
+    struct ARENA_SLOT *next;
+} arena_slot_t;
+
+/* Larger object in a bin, which has to remember its size */
+typedef struct ARENA_BLOCK {
+    struct ARENA_BLOCK *next;
+    size_t size;
+} arena_block_t;
+
+typedef struct {
+    arena_chunk_t *chunks;  /* Every chunk allocated so far */
+    arena_chunk_t *oldest;  /* Last chunk of the list, to merge in O(1) */
+    size_t chunk_size;      /* Size of the next chunk */
+    char *cursor;           /* Next free byte in the newest chunk */
+    char *limit;            /* End of the newest chunk */
+    arena_slot_t *freelist[ARENA_CLASSES];
+    arena_block_t *bins[ARENA_BINS];
+    /* Last object of each freelist and bin, if not empty */
+    arena_slot_t *freelist_last[ARENA_CLASSES];
+    arena_block_t *bins_last[ARENA_BINS];
+} arena_t;
+
+/*
+ * Prepare an empty arena.
+ * Return false if the first chunk could not be allocated.
+ */
+bool arena_init(arena_t *a);
+
+/*
+ * Get size bytes from the arena.
+ * Return NULL if a new chunk was needed but could not be allocated.
+ */
+void *arena_alloc(arena_t *a, size_t size);
+
+/* Give back an object of size bytes obtained from arena_alloc() */
+void arena_free(arena_t *a, void *obj, size_t size);
+
+/*
+ * Move every chunk of src, with its objects, into dst, leaving src empty.
+ * Takes time proportional to the number of freelists and bins, not to the
+ * objects they hold.  Objects obtained from src are then given back to dst.
+ */
+void arena_merge(arena_t *dst, arena_t *src);
+
+/* Release every chunk of the arena.  All objects become invalid. */
+void arena_destroy(arena_t *a);
+
+#endif /* LAB0_ARENA_H */
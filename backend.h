@@ -0,0 +1,84 @@
+#ifndef LAB0_BACKEND_H
+#define LAB0_BACKEND_H
+
+/*
+ * Interface between queue.c and the alternative ways of storing the
+ * elements of a queue.
+ *
+ * The singly-linked list of list_ele_t is implemented in queue.c itself.
+ * Every other backend provides one of these tables.  queue.c takes care of
+ * the NULL checks of the public API, so the functions are always called
+ * with a valid queue.  They must keep q->size up to date.
+ */
+
+#include "arena.h"
+#include "pool.h"
+#include "queue.h"
+
+/*
+ * Allocators of the elements of a queue.  Queues exchanging elements
+ * through q_concat() or q_split() end up sharing them, so every element is
+ * released where it was allocated.  They go away with their last user.
+ */
+typedef struct MEM {
+    pool_t pool;    /* List elements, or blocks of the unrolled backend */
+    arena_t arena;  /* Elements and strings of ARENA_LAYOUT */
+    queue_t *users; /* Queues drawing from here, linked through mem_next */
+} mem_t;
+
+typedef struct BACKEND {
+    /* Set up the storage of an empty queue. Return false if no space */
+    bool (*init)(queue_t *q);
+    /* Free every element and the storage set up by init, but q->mem */
+    void (*release)(queue_t *q);
+    /* Store a copy of the len bytes of s */
+    bool (*insert_head)(queue_t *q, const char *s, size_t len);
+    bool (*insert_tail)(queue_t *q, const char *s, size_t len);
+    /*
+     * Unlink the head, called only for queues that are not empty.
+     * Its string is handed over, and released with free().  Return NULL,
+     * leaving q as it was, if the string could not be allocated.
+     */
+    char *(*take_head)(queue_t *q);
+    char *(*take_tail)(queue_t *q);
+    /* Called only for queues that are not empty */
+    char *(*peek_head)(queue_t *q);
+    /* Called only for queues with more than one element */
+    void (*reverse)(queue_t *q);
+    void (*sort)(queue_t *q);
+    /*
+     * Move the elements of src, which is not empty, to the tail of dst, or
+     * those of q after the first n, 0 <= n < q->size, to the tail of out.
+     * Both queues already share their mem.
+     */
+    bool (*concat)(queue_t *dst, queue_t *src);
+    bool (*split)(queue_t *q, int n, queue_t *out);
+    /* Walk the strings from head to tail, see q_iter_init() */
+    void (*iter_init)(q_iter_t *it);
+    char *(*iter_next)(q_iter_t *it);
+    /*
+     * Optional, NULL to let queue.c walk the strings instead.  get_nth is
+     * called with 0 <= n < q->size, iter_seek after iter_init.
+     */
+    char *(*get_nth)(queue_t *q, int n);
+    int (*rank)(queue_t *q, const char *s);
+    void (*iter_seek)(q_iter_t *it, int n);
+    /* Optional, NULL if removed strings give their storage back at once */
+    size_t (*dead_bytes)(queue_t *q);
+} backend_t;
+
+extern const backend_t unrolled_backend;
+extern const backend_t ring_backend;
+extern const backend_t dlist_backend;
+extern const backend_t compact_backend;
+extern const backend_t heap_backend;
+extern const backend_t skiplist_backend;
+
+/*
+ * Allocate a null-terminated copy of the len bytes of s, with malloc().
+ * Backends store their strings this way.
+ * Return NULL if could not allocate space.
+ */
+char *backend_copy_string(const char *s, size_t len);
+
+#endif /* LAB0_BACKEND_H */
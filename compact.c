@@ -0,0 +1,431 @@
+/*
+ * Compact backend for huge queues.
+ *
+ * Nodes live in one growable array and link to each other with 32-bit
+ * indices, and the strings are packed one after the other in a single
+ * byte heap, addressed by 32-bit offsets.  Each element costs 8 bytes of
+ * node plus its string bytes, without any per-element allocation.
+ *
+ * Removed nodes are recycled through a freelist.  Bytes of removed strings
+ * stay in the heap until it runs out of room, when the live strings are
+ * packed again into a heap sized for them.  Strings handed out by
+ * take_head and take_tail are copied out of the heap, since they must be
+ * released with free().
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "backend.h"
+#include "harness.h"
+#include "merge_runs.h"
+
+/* Index of no node, ending the list and the freelist */
+#define NIL UINT32_MAX
+
+/* Initial number of nodes and of heap bytes */
+#define COMPACT_MIN_NODES 64
+#define COMPACT_MIN_HEAP 1024
+
+typedef struct {
+    uint32_t next; /* Index of the next node, or NIL */
+    uint32_t off;  /* Offset of the string in the heap */
+} cnode_t;
+
+typedef struct {
+    cnode_t *nodes;
+    uint32_t node_cap;   /* Number of nodes in the array */
+    uint32_t node_used;  /* Nodes below this index have been handed out */
+    uint32_t free_node;  /* Freelist of removed nodes, linked by next */
+    uint32_t free_count; /* Number of nodes on the freelist */
+    uint32_t head, tail;
+
+    char *heap;
+    size_t heap_cap;  /* Bytes in the heap, never more than UINT32_MAX */
+    size_t heap_used; /* Bytes below this offset have been handed out */
+    size_t heap_dead; /* Bytes of removed strings among them */
+} compact_t;
+
+#define NODE(c, i) (&(c)->nodes[i])
+#define VALUE(c, i) ((c)->heap + (c)->nodes[i].off)
+
+static bool compact_init(queue_t *q)
+{
+    compact_t *c = malloc(sizeof(compact_t));
+    if (!c)
+        return false;
+    c->nodes = malloc(COMPACT_MIN_NODES * sizeof(cnode_t));
+    c->heap = malloc(COMPACT_MIN_HEAP);
+    if (!c->nodes || !c->heap) {
+        free(c->nodes);
+        free(c->heap);
+        free(c);
+        return false;
+    }
+
+    c->node_cap = COMPACT_MIN_NODES;
+    c->node_used = 0;
+    c->free_node = NIL;
+    c->free_count = 0;
+    c->head = NIL;
+    c->tail = NIL;
+    c->heap_cap = COMPACT_MIN_HEAP;
+    c->heap_used = 0;
+    c->heap_dead = 0;
+    q->store = c;
+    return true;
+}
+
+static void compact_release(queue_t *q)
+{
+    compact_t *c = q->store;
+
+    free(c->nodes);
+    free(c->heap);
+    free(c);
+}
+
+/*
+ * Make sure n more nodes and bytes more heap bytes can be handed out
+ * without allocating.  The heap is rebuilt with only the live strings,
+ * and grown if they leave too little room.
+ * Return false if could not allocate space.
+ */
+static bool reserve(queue_t *q, size_t n, size_t bytes)
+{
+    compact_t *c = q->store;
+
+    if (c->free_count + (c->node_cap - c->node_used) < n) {
+        size_t cap = c->node_cap;
+        while (cap - c->node_used + c->free_count < n)
+            cap *= 2;
+        if (cap >= NIL)
+            return false;
+
+        cnode_t *nodes = malloc(cap * sizeof(cnode_t));
+        if (!nodes)
+            return false;
+        memcpy(nodes, c->nodes, c->node_used * sizeof(cnode_t));
+        free(c->nodes);
+        c->nodes = nodes;
+        c->node_cap = cap;
+    }
+
+    if (c->heap_cap - c->heap_used < bytes) {
+        /* Leave room for half as many bytes again, so rebuilds stay rare */
+        size_t live = c->heap_used - c->heap_dead;
+        size_t cap = c->heap_cap;
+        while (cap < live + bytes + live / 2)
+            cap *= 2;
+        if (cap > UINT32_MAX)
+            return false;
+
+        char *heap = malloc(cap);
+        if (!heap)
+            return false;
+        size_t used = 0;
+        for (uint32_t i = c->head; i != NIL; i = NODE(c, i)->next) {
+            size_t len = strlen(VALUE(c, i)) + 1;
+            memcpy(heap + used, VALUE(c, i), len);
+            NODE(c, i)->off = used;
+            used += len;
+        }
+        free(c->heap);
+        c->heap = heap;
+        c->heap_cap = cap;
+        c->heap_used = used;
+        c->heap_dead = 0;
+    }
+
+    return true;
+}
+
+/* Store a copy of s in a new node, with room already reserved */
+static uint32_t node_new(compact_t *c, const char *s, size_t len)
+{
+    uint32_t i;
+
+    if (c->free_node != NIL) {
+        i = c->free_node;
+        c->free_node = NODE(c, i)->next;
+        c->free_count--;
+    } else {
+        i = c->node_used++;
+    }
+
+    NODE(c, i)->off = c->heap_used;
+    memcpy(c->heap + c->heap_used, s, len);
+    c->heap[c->heap_used + len] = '\0';
+    c->heap_used += len + 1;
+    return i;
+}
+
+/* Put an unlinked node on the freelist, and account for its string */
+static void node_free(queue_t *q, uint32_t i)
+{
+    compact_t *c = q->store;
+
+    c->heap_dead += strlen(VALUE(c, i)) + 1;
+    NODE(c, i)->next = c->free_node;
+    c->free_node = i;
+    c->free_count++;
+
+    /* Once empty, the arrays can be handed out from their start again */
+    if (!--q->size) {
+        c->node_used = 0;
+        c->free_node = NIL;
+        c->free_count = 0;
+        c->heap_used = 0;
+        c->heap_dead = 0;
+    }
+}
+
+static bool compact_insert_head(queue_t *q, const char *s, size_t len)
+{
+    compact_t *c = q->store;
+
+    if (!reserve(q, 1, len + 1))
+        return false;
+
+    uint32_t i = node_new(c, s, len);
+    NODE(c, i)->next = c->head;
+    c->head = i;
+    if (c->tail == NIL)
+        c->tail = i;
+    q->size++;
+    return true;
+}
+
+/* Link node i, which is new, after the tail */
+static void append(queue_t *q, uint32_t i)
+{
+    compact_t *c = q->store;
+
+    NODE(c, i)->next = NIL;
+    if (c->tail != NIL)
+        NODE(c, c->tail)->next = i;
+    else
+        c->head = i;
+    c->tail = i;
+    q->size++;
+}
+
+static bool compact_insert_tail(queue_t *q, const char *s, size_t len)
+{
+    compact_t *c = q->store;
+
+    if (!reserve(q, 1, len + 1))
+        return false;
+
+    append(q, node_new(c, s, len));
+    return true;
+}
+
+static char *compact_take_head(queue_t *q)
+{
+    compact_t *c = q->store;
+    uint32_t i = c->head;
+
+    char *value = strdup(VALUE(c, i));
+    if (!value)
+        return NULL;
+
+    c->head = NODE(c, i)->next;
+    if (c->head == NIL)
+        c->tail = NIL;
+    node_free(q, i);
+    return value;
+}
+
+static char *compact_take_tail(queue_t *q)
+{
+    compact_t *c = q->store;
+    uint32_t i = c->tail;
+
+    char *value = strdup(VALUE(c, i));
+    if (!value)
+        return NULL;
+
+    /* Singly linked, so the new tail has to be found from the head */
+    if (c->head == i) {
+        c->head = NIL;
+        c->tail = NIL;
+    } else {
+        uint32_t prev = c->head;
+        while (NODE(c, prev)->next != i)
+            prev = NODE(c, prev)->next;
+        NODE(c, prev)->next = NIL;
+        c->tail = prev;
+    }
+    node_free(q, i);
+    return value;
+}
+
+static char *compact_peek_head(queue_t *q)
+{
+    compact_t *c = q->store;
+    return VALUE(c, c->head);
+}
+
+static void compact_reverse(queue_t *q)
+{
+    compact_t *c = q->store;
+    uint32_t prev = NIL;
+
+    c->tail = c->head;
+    for (uint32_t i = c->head; i != NIL;) {
+        uint32_t next = NODE(c, i)->next;
+        NODE(c, i)->next = prev;
+        prev = i;
+        i = next;
+    }
+    c->head = prev;
+}
+
+/* Merge two sorted runs of nodes, see run_merge_t */
+static run_t merge(void *priv, run_t a, run_t b)
+{
+    compact_t *c = priv;
+    uint32_t i = (cnode_t *) a.head - c->nodes;
+    uint32_t j = (cnode_t *) b.head - c->nodes;
+    uint32_t head = NIL, *indirect = &head;
+
+    while (i != NIL && j != NIL) {
+        uint32_t *min = strcmp(VALUE(c, j), VALUE(c, i)) < 0 ? &j : &i;
+        *indirect = *min;
+        indirect = &NODE(c, *min)->next;
+        *min = NODE(c, *min)->next;
+    }
+    *indirect = i != NIL ? i : j;
+    return (run_t){NODE(c, head), i != NIL ? a.tail : b.tail};
+}
+
+static void compact_sort(queue_t *q)
+{
+    compact_t *c = q->store;
+    merge_bins_t mb;
+
+    merge_bins_init(&mb, merge, c);
+    for (uint32_t i = c->head; i != NIL;) {
+        cnode_t *node = NODE(c, i);
+        i = node->next;
+        node->next = NIL;
+        merge_bins_add(&mb, node);
+    }
+
+    run_t sorted = merge_bins_finish(&mb);
+    c->head = (cnode_t *) sorted.head - c->nodes;
+    c->tail = (cnode_t *) sorted.tail - c->nodes;
+}
+
+/*
+ * Copy the strings of src from node first on to the tail of dst, whose room
+ * is reserved.  Nodes only link within their own array, so elements cannot
+ * move between queues without their bytes.
+ */
+static void copy_nodes(queue_t *dst, compact_t *src, uint32_t first)
+{
+    compact_t *d = dst->store;
+
+    for (uint32_t i = first; i != NIL; i = NODE(src, i)->next)
+        append(dst, node_new(d, VALUE(src, i), strlen(VALUE(src, i))));
+}
+
+/* Bytes of the strings from node first on */
+static size_t chain_bytes(compact_t *c, uint32_t first)
+{
+    size_t bytes = 0;
+    for (uint32_t i = first; i != NIL; i = NODE(c, i)->next)
+        bytes += strlen(VALUE(c, i)) + 1;
+    return bytes;
+}
+
+static bool compact_concat(queue_t *dst, queue_t *src)
+{
+    compact_t *s = src->store;
+
+    if (!reserve(dst, src->size, s->heap_used - s->heap_dead))
+        return false;
+
+    copy_nodes(dst, s, s->head);
+
+    /* Nothing of src is left, empty it at once */
+    s->head = NIL;
+    s->tail = NIL;
+    s->node_used = 0;
+    s->free_node = NIL;
+    s->free_count = 0;
+    s->heap_used = 0;
+    s->heap_dead = 0;
+    src->size = 0;
+    return true;
+}
+
+static bool compact_split(queue_t *q, int n, queue_t *out)
+{
+    compact_t *c = q->store;
+
+    uint32_t last = NIL, first = c->head;
+    for (int k = 0; k < n; k++) {
+        last = first;
+        first = NODE(c, first)->next;
+    }
+
+    if (!reserve(out, q->size - n, chain_bytes(c, first)))
+        return false;
+    copy_nodes(out, c, first);
+
+    if (last != NIL)
+        NODE(c, last)->next = NIL;
+    else
+        c->head = NIL;
+    c->tail = last;
+    for (uint32_t i = first; i != NIL;) {
+        uint32_t next = NODE(c, i)->next;
+        node_free(q, i);
+        i = next;
+    }
+    return true;
+}
+
+static void compact_iter_init(q_iter_t *it)
+{
+    compact_t *c = it->q->store;
+
+    it->node = c->head != NIL ? NODE(c, c->head) : NULL;
+}
+
+static char *compact_iter_next(q_iter_t *it)
+{
+    compact_t *c = it->q->store;
+    cnode_t *n = it->node;
+
+    if (!n)
+        return NULL;
+    it->node = n->next != NIL ? NODE(c, n->next) : NULL;
+    return c->heap + n->off;
+}
+
+static size_t compact_dead_bytes(queue_t *q)
+{
+    compact_t *c = q->store;
+    return c->heap_dead;
+}
+
+const backend_t compact_backend = {
+    .init = compact_init,
+    .release = compact_release,
+    .insert_head = compact_insert_head,
+    .insert_tail = compact_insert_tail,
+    .take_head = compact_take_head,
+    .take_tail = compact_take_tail,
+    .peek_head = compact_peek_head,
+    .reverse = compact_reverse,
+    .sort = compact_sort,
+    .concat = compact_concat,
+    .split = compact_split,
+    .iter_init = compact_iter_init,
+    .iter_next = compact_iter_next,
+    .dead_bytes = compact_dead_bytes,
+};
@@ -0,0 +1,237 @@
+/*
+ * Doubly-linked list backend.
+ *
+ * Every node links to both of its neighbours through an embedded
+ * struct list_head, so either end of the queue can be removed in O(1).
+ * Which end is the head depends on a direction flag, which lets
+ * q_reverse() flip the queue in O(1) without touching a single node.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "backend.h"
+#include "harness.h"
+#include "list.h"
+
+typedef struct {
+    struct list_head list;
+    char *value;
+} dnode_t;
+
+typedef struct {
+    struct list_head head;
+    bool reversed; /* Whether the head of the queue is head.prev */
+} dlist_t;
+
+/* Node at the head or at the tail of a list, which must not be empty */
+#define HEAD_NODE(l) ((l)->reversed ? (l)->head.prev : (l)->head.next)
+#define TAIL_NODE(l) ((l)->reversed ? (l)->head.next : (l)->head.prev)
+
+static bool dlist_init(queue_t *q)
+{
+    dlist_t *l = malloc(sizeof(dlist_t));
+    if (!l)
+        return false;
+    if (!pool_init(&q->mem->pool, sizeof(dnode_t))) {
+        free(l);
+        return false;
+    }
+
+    INIT_LIST_HEAD(&l->head);
+    l->reversed = false;
+    q->store = l;
+    return true;
+}
+
+static void dlist_release(queue_t *q)
+{
+    dlist_t *l = q->store;
+    dnode_t *n, *safe;
+
+    list_for_each_entry_safe (n, safe, &l->head, list) {
+        free(n->value);
+        /* The pool may be shared with other queues, see q_concat() */
+        pool_free(&q->mem->pool, n);
+    }
+
+    free(l);
+}
+
+static bool dlist_insert(queue_t *q, const char *s, size_t len, bool tail)
+{
+    dlist_t *l = q->store;
+    dnode_t *n = pool_alloc(&q->mem->pool);
+    if (!n)
+        return false;
+    n->value = backend_copy_string(s, len);
+    if (!n->value) {
+        pool_free(&q->mem->pool, n);
+        return false;
+    }
+
+    /* The physical end is the logical one, unless the list is reversed */
+    if (tail != l->reversed)
+        list_add_tail(&n->list, &l->head);
+    else
+        list_add(&n->list, &l->head);
+    q->size++;
+    return true;
+}
+
+static bool dlist_insert_head(queue_t *q, const char *s, size_t len)
+{
+    return dlist_insert(q, s, len, false);
+}
+
+static bool dlist_insert_tail(queue_t *q, const char *s, size_t len)
+{
+    return dlist_insert(q, s, len, true);
+}
+
+static char *dlist_take(queue_t *q, struct list_head *node)
+{
+    dnode_t *n = list_entry(node, dnode_t, list);
+    char *value = n->value;
+
+    list_del(node);
+    pool_free(&q->mem->pool, n);
+    q->size--;
+    return value;
+}
+
+static char *dlist_take_head(queue_t *q)
+{
+    return dlist_take(q, HEAD_NODE((dlist_t *) q->store));
+}
+
+static char *dlist_take_tail(queue_t *q)
+{
+    return dlist_take(q, TAIL_NODE((dlist_t *) q->store));
+}
+
+static char *dlist_peek_head(queue_t *q)
+{
+    return list_entry(HEAD_NODE((dlist_t *) q->store), dnode_t, list)->value;
+}
+
+static void dlist_reverse(queue_t *q)
+{
+    dlist_t *l = q->store;
+    l->reversed = !l->reversed;
+}
+
+/* Swap the links of every node, so the list keeps its order with the flag */
+static void flip(dlist_t *l)
+{
+    struct list_head *node = &l->head;
+
+    do {
+        struct list_head *next = node->next;
+        node->next = node->prev;
+        node->prev = next;
+        node = next;
+    } while (node != &l->head);
+
+    l->reversed = !l->reversed;
+}
+
+static int dnode_cmp(void *priv,
+                     const struct list_head *a,
+                     const struct list_head *b)
+{
+    return strcmp(list_entry(a, dnode_t, list)->value,
+                  list_entry(b, dnode_t, list)->value);
+}
+
+static void dlist_sort(queue_t *q)
+{
+    dlist_t *l = q->store;
+
+    /* list_sort() orders the physical list, so drop the flag first */
+    if (l->reversed)
+        flip(l);
+    list_sort(NULL, &l->head, dnode_cmp);
+}
+
+static bool dlist_concat(queue_t *dst, queue_t *src)
+{
+    dlist_t *d = dst->store, *s = src->store;
+
+    /* Both lists must run the same way, flip the shorter one if not */
+    if (d->reversed != s->reversed)
+        flip(dst->size < src->size ? d : s);
+
+    if (d->reversed)
+        list_splice_init(&s->head, &d->head);
+    else
+        list_splice_tail_init(&s->head, &d->head);
+    dst->size += src->size;
+    src->size = 0;
+    return true;
+}
+
+static bool dlist_split(queue_t *q, int n, queue_t *out)
+{
+    dlist_t *l = q->store;
+
+    if (l->reversed)
+        flip(l);
+
+    /* Walk from whichever end is closer to the last node kept */
+    struct list_head *last = &l->head;
+    if (n <= q->size / 2) {
+        for (int i = 0; i < n; i++)
+            last = last->next;
+    } else {
+        for (int i = q->size; i >= n; i--)
+            last = last->prev;
+    }
+
+    /* Set the nodes kept aside, so the others can move to a list of theirs */
+    LIST_HEAD(kept);
+    list_cut_position(&kept, &l->head, last);
+
+    dlist_t moved = {.reversed = false};
+    INIT_LIST_HEAD(&moved.head);
+    list_splice_tail_init(&l->head, &moved.head);
+    list_splice(&kept, &l->head);
+
+    queue_t tmp = {.size = q->size - n, .store = &moved};
+    q->size = n;
+    return dlist_concat(out, &tmp);
+}
+
+static void dlist_iter_init(q_iter_t *it)
+{
+    dlist_t *l = it->q->store;
+
+    it->node = l->reversed ? l->head.prev : l->head.next;
+}
+
+static char *dlist_iter_next(q_iter_t *it)
+{
+    dlist_t *l = it->q->store;
+    struct list_head *node = it->node;
+
+    if (node == &l->head)
+        return NULL;
+    it->node = l->reversed ? node->prev : node->next;
+    return list_entry(node, dnode_t, list)->value;
+}
+
+const backend_t dlist_backend = {
+    .init = dlist_init,
+    .release = dlist_release,
+    .insert_head = dlist_insert_head,
+    .insert_tail = dlist_insert_tail,
+    .take_head = dlist_take_head,
+    .take_tail = dlist_take_tail,
+    .peek_head = dlist_peek_head,
+    .reverse = dlist_reverse,
+    .sort = dlist_sort,
+    .concat = dlist_concat,
+    .split = dlist_split,
+    .iter_init = dlist_iter_init,
+    .iter_next = dlist_iter_next,
+};
@@ -1,5 +1,6 @@
 /* Test support code */
 
+#include <pthread.h>
 #include <setjmp.h>
 #include <signal.h>
 #include <stdio.h>
@@ -43,6 +44,21 @@ typedef struct BELE {
 
 static block_ele_t *allocated = NULL;
 static size_t allocated_count = 0;
+static size_t allocated_bytes = 0;
+
+/* Guard of the allocated blocks, which a reclaiming thread frees as well */
+static pthread_mutex_t allocated_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Whether the calling thread holds allocated_lock.  An exception raised
+ * meanwhile is deferred until the caller is done with the block, as
+ * jumping out would leave the lock held, or the block half freed.
+ */
+static _Thread_local volatile sig_atomic_t in_allocated = false;
+static _Thread_local char *volatile deferred_message = NULL;
+
+/* Whether the calling thread frees on behalf of q_free() */
+static _Thread_local bool reclaiming = false;
 
 /* Percent probability of malloc failure */
 int fail_probability = 0;
@@ -72,9 +88,32 @@ static bool fail_allocation()
     return (weight < 0.01 * fail_probability);
 }
 
+static void allocated_enter()
+{
+    in_allocated = true;
+    pthread_mutex_lock(&allocated_lock);
+}
+
+static void allocated_leave()
+{
+    pthread_mutex_unlock(&allocated_lock);
+    in_allocated = false;
+}
+
+/* Raise the exception deferred while the calling thread held the lock */
+static void raise_deferred()
+{
+    char *msg = deferred_message;
+    if (msg) {
+        deferred_message = NULL;
+        trigger_exception(msg);
+    }
+}
+
 /*
  * Find header of block, given its payload.
- * Signal error if doesn't seem like legitimate block
+ * Signal error if doesn't seem like legitimate block.
+ * Return NULL if an exception was deferred during the search.
  */
 static block_ele_t *find_header(void *p)
 {
@@ -84,11 +123,13 @@ static block_ele_t *find_header(void *p)
     }
 
     block_ele_t *b = (block_ele_t *) ((size_t) p - sizeof(block_ele_t));
-    if (cautious_mode) {
+    if (!reclaiming && cautious_mode) {
         /* Make sure this is really an allocated block */
         block_ele_t *ab = allocated;
         bool found = false;
         while (ab && !found) {
+            if (deferred_message)
+                return NULL;
             found = ab == b;
             ab = ab->next;
         }
@@ -148,6 +189,8 @@ void *test_malloc(size_t size)
     *find_footer(new_block) = MAGICFOOTER;
     void *p = (void *) &new_block->payload;
     memset(p, FILLCHAR, size);
+
+    allocated_enter();
     // cppcheck-suppress nullPointerRedundantCheck
     new_block->next = allocated;
     // cppcheck-suppress nullPointerRedundantCheck
@@ -157,6 +200,9 @@ void *test_malloc(size_t size)
         allocated->prev = new_block;
     allocated = new_block;
     allocated_count++;
+    allocated_bytes += size;
+    allocated_leave();
+    raise_deferred();
 
     return p;
 }
@@ -175,7 +221,7 @@ void *test_calloc(size_t nelem, size_t elsize)
 
 void test_free(void *p)
 {
-    if (noallocate_mode) {
+    if (!reclaiming && noallocate_mode) {
         report_event(MSG_FATAL, "Calls to free disallowed");
         return;
     }
@@ -183,7 +229,14 @@ void test_free(void *p)
     if (!p)
         return;
 
+    allocated_enter();
     block_ele_t *b = find_header(p);
+    if (!b) {
+        /* Raise the exception before anything changed */
+        allocated_leave();
+        raise_deferred();
+        return;
+    }
     size_t footer = *find_footer(b);
     if (footer != MAGICFOOTER) {
         report_event(MSG_ERROR,
@@ -195,6 +248,7 @@ void test_free(void *p)
     b->magic_header = MAGICFREE;
     *find_footer(b) = MAGICFREE;
     memset(p, FILLCHAR, b->payload_size);
+    allocated_bytes -= b->payload_size;
 
     /* Unlink from list */
     block_ele_t *bn = b->next;
@@ -206,8 +260,16 @@ void test_free(void *p)
     if (bn)
         bn->prev = bp;
 
-    free(b);
     allocated_count--;
+    allocated_leave();
+
+    free(b);
+    raise_deferred();
+}
+
+void test_reclaim_thread()
+{
+    reclaiming = true;
 }
 
 // cppcheck-suppress unusedFunction
@@ -226,6 +288,11 @@ size_t allocation_check()
     return allocated_count;
 }
 
+size_t allocation_bytes()
+{
+    return allocated_bytes;
+}
+
 /*
  * Implementation of functions for testing
  */
@@ -306,6 +373,15 @@ void exception_cancel()
  */
 void trigger_exception(char *msg)
 {
+    if (in_allocated) {
+        deferred_message = msg;
+        return;
+    }
+
+    /* The reclaimer has no exception setup of its own to return to */
+    if (reclaiming)
+        report_event(MSG_FATAL, msg);
+
     error_occurred = true;
     error_message = msg;
     if (jmp_ready)
@@ -17,11 +17,21 @@ void test_free(void *p);
 char *test_strdup(const char *s);
 /* FIXME: provide test_realloc as well */
 
+/*
+ * Mark the calling thread as one releasing queues handed over by q_free().
+ * Its calls to free are allowed in restricted allocation mode, and skip
+ * the search of cautious mode, which would make the release quadratic.
+ */
+void test_reclaim_thread();
+
 #ifdef INTERNAL
 
 /* Report number of allocated blocks */
 size_t allocation_check();
 
+/* Report number of bytes requested by the allocated blocks */
+size_t allocation_bytes();
+
 /* Probability of malloc failing, expressed as percent */
 extern int fail_probability;
 
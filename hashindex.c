@@ -0,0 +1,248 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "harness.h"
+#include "hashindex.h"
+
+/* Initial number of slots, a power of two, and of heap bytes */
+#define HINDEX_MIN_SLOTS 64
+#define HINDEX_MIN_HEAP 1024
+
+typedef struct {
+    uint32_t hash;
+    uint32_t count; /* Occurrences of the string, 0 for an empty slot */
+    uint32_t off;   /* Offset of the entry of its key in the heap */
+} hslot_t;
+
+struct HINDEX {
+    hslot_t *slots;
+    size_t nslots; /* Always a power of two */
+    size_t used;   /* Slots holding a string */
+
+    char *heap;
+    size_t heap_cap;
+    size_t heap_used; /* Bytes below this offset have been handed out */
+    size_t heap_dead; /* Bytes of keys no longer counted among them */
+};
+
+#define KEY_LEN(h, off) (*(const uint32_t *) ((h)->heap + (off)))
+#define KEY(h, off) ((h)->heap + (off) + sizeof(uint32_t))
+
+uint32_t hash_string(const char *s, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char) s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/*
+ * Return the slot holding the len bytes of s, or the empty slot ending its
+ * probe sequence if it is not there.  The table always has an empty slot.
+ */
+static size_t find(const hindex_t *h, const char *s, size_t len, uint32_t hash)
+{
+    size_t mask = h->nslots - 1, i = hash & mask;
+
+    for (; h->slots[i].count; i = (i + 1) & mask) {
+        const hslot_t *slot = &h->slots[i];
+        if (slot->hash == hash && KEY_LEN(h, slot->off) == len &&
+            !memcmp(KEY(h, slot->off), s, len))
+            break;
+    }
+    return i;
+}
+
+hindex_t *hindex_new()
+{
+    hindex_t *h = malloc(sizeof(hindex_t));
+    if (!h)
+        return NULL;
+    h->slots = malloc(HINDEX_MIN_SLOTS * sizeof(hslot_t));
+    h->heap = malloc(HINDEX_MIN_HEAP);
+    if (!h->slots || !h->heap) {
+        free(h->slots);
+        free(h->heap);
+        free(h);
+        return NULL;
+    }
+
+    h->nslots = HINDEX_MIN_SLOTS;
+    h->heap_cap = HINDEX_MIN_HEAP;
+    hindex_clear(h);
+    return h;
+}
+
+void hindex_free(hindex_t *h)
+{
+    if (!h)
+        return;
+    free(h->slots);
+    free(h->heap);
+    free(h);
+}
+
+void hindex_clear(hindex_t *h)
+{
+    memset(h->slots, 0, h->nslots * sizeof(hslot_t));
+    h->used = 0;
+    h->heap_used = 0;
+    h->heap_dead = 0;
+}
+
+/* Move every slot into a table twice as large */
+static bool grow_slots(hindex_t *h)
+{
+    size_t n = 2 * h->nslots, mask = n - 1;
+    hslot_t *slots = malloc(n * sizeof(hslot_t));
+    if (!slots)
+        return false;
+    memset(slots, 0, n * sizeof(hslot_t));
+
+    for (size_t i = 0; i < h->nslots; i++) {
+        if (!h->slots[i].count)
+            continue;
+        size_t j = h->slots[i].hash & mask;
+        while (slots[j].count)
+            j = (j + 1) & mask;
+        slots[j] = h->slots[i];
+    }
+
+    free(h->slots);
+    h->slots = slots;
+    h->nslots = n;
+    return true;
+}
+
+/*
+ * Make room for size more bytes in the heap.  The keys still counted are
+ * moved to a fresh heap, half as large again as they need with the new
+ * bytes.  If some keys are no longer counted, the others are packed in
+ * slot order, which drops their bytes; otherwise they keep their offsets.
+ */
+static bool reserve_heap(hindex_t *h, size_t size)
+{
+    if (h->heap_used + size <= h->heap_cap)
+        return true;
+
+    size_t live = h->heap_used - h->heap_dead;
+    if (live + size > UINT32_MAX)
+        return false;
+    size_t cap = (live + size) + (live + size) / 2;
+    if (cap < HINDEX_MIN_HEAP)
+        cap = HINDEX_MIN_HEAP;
+    if (cap > UINT32_MAX)
+        cap = UINT32_MAX;
+    char *heap = malloc(cap);
+    if (!heap)
+        return false;
+
+    size_t used = 0;
+    if (!h->heap_dead) {
+        memcpy(heap, h->heap, h->heap_used);
+        used = h->heap_used;
+    }
+    for (size_t i = 0; h->heap_dead && i < h->nslots; i++) {
+        hslot_t *slot = &h->slots[i];
+        if (!slot->count)
+            continue;
+        size_t n = HINDEX_ENTRY_SIZE(KEY_LEN(h, slot->off));
+        memcpy(heap + used, h->heap + slot->off, n);
+        slot->off = used;
+        used += n;
+    }
+
+    free(h->heap);
+    h->heap = heap;
+    h->heap_cap = cap;
+    h->heap_used = used;
+    h->heap_dead = 0;
+    return true;
+}
+
+int64_t hindex_add_key(hindex_t *h, const char *s, size_t len)
+{
+    uint32_t hash = hash_string(s, len);
+    size_t i = find(h, s, len, hash);
+
+    if (h->slots[i].count) {
+        h->slots[i].count++;
+        return h->slots[i].off;
+    }
+
+    if (len > UINT32_MAX - 2 * sizeof(uint32_t))
+        return -1;
+    size_t size = HINDEX_ENTRY_SIZE(len);
+    if (!reserve_heap(h, size))
+        return -1;
+    /* Keep the table at most three quarters full */
+    if (4 * (h->used + 1) > 3 * h->nslots) {
+        if (!grow_slots(h))
+            return -1;
+        i = find(h, s, len, hash);
+    }
+
+    char *entry = h->heap + h->heap_used;
+    uint32_t n = len;
+    memcpy(entry, &n, sizeof(n));
+    memcpy(entry + sizeof(n), s, len);
+    memset(entry + sizeof(n) + len, 0, size - sizeof(n) - len);
+
+    h->slots[i].hash = hash;
+    h->slots[i].count = 1;
+    h->slots[i].off = h->heap_used;
+    h->heap_used += size;
+    h->used++;
+    return h->slots[i].off;
+}
+
+bool hindex_add(hindex_t *h, const char *s, size_t len)
+{
+    return hindex_add_key(h, s, len) >= 0;
+}
+
+void hindex_remove(hindex_t *h, const char *s, size_t len)
+{
+    size_t mask = h->nslots - 1;
+    size_t i = find(h, s, len, hash_string(s, len));
+
+    if (!h->slots[i].count || --h->slots[i].count)
+        return;
+    h->heap_dead += HINDEX_ENTRY_SIZE(len);
+    h->used--;
+
+    /*
+     * Empty slot i, then shift back into it the first slot after it that
+     * would not be found past the hole, and repeat from that slot.
+     */
+    for (size_t j = i;;) {
+        j = (j + 1) & mask;
+        if (!h->slots[j].count)
+            break;
+        size_t home = h->slots[j].hash & mask;
+        if (i <= j ? i < home && home <= j : i < home || home <= j)
+            continue;
+        h->slots[i] = h->slots[j];
+        i = j;
+    }
+    h->slots[i].count = 0;
+}
+
+size_t hindex_size(const hindex_t *h)
+{
+    return h->used;
+}
+
+const char *hindex_keys(const hindex_t *h, size_t *bytes)
+{
+    *bytes = h->heap_used;
+    return h->heap;
+}
+
+int hindex_count(const hindex_t *h, const char *s, size_t len)
+{
+    return h->slots[find(h, s, len, hash_string(s, len))].count;
+}
@@ -0,0 +1,76 @@
+#ifndef LAB0_HASHINDEX_H
+#define LAB0_HASHINDEX_H
+
+/*
+ * Hash index counting the strings of a queue.
+ *
+ * Each distinct string takes one 12-byte slot of an open-addressing table
+ * with linear probing, holding its hash, its count and the offset of its
+ * key.  Keys are packed one after the other in a single byte heap, each as
+ * an entry of HINDEX_ENTRY_SIZE() bytes, so the index makes one allocation
+ * for the slots and one for the keys, however many strings it counts.
+ * Slots of strings whose count drops to zero are emptied by shifting back
+ * the slots probed after them, which leaves no tombstone behind; their key
+ * bytes are reclaimed when the heap runs out of room.
+ *
+ * Until a string is removed, keys stay in the order they were added, at the
+ * offsets they were added at, which is how q_save() writes its table.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct HINDEX hindex_t;
+
+/*
+ * Bytes of the entry of a key of len bytes: its 32-bit length, its bytes,
+ * a null terminator, and zeroes up to a multiple of 4.
+ */
+#define HINDEX_ENTRY_SIZE(len) \
+    ((sizeof(uint32_t) + (len) + 1 + 3) & ~(size_t) 3)
+
+/* 32-bit FNV-1a hash of the len bytes of s, shared by the string tables */
+uint32_t hash_string(const char *s, size_t len);
+
+/*
+ * Create an empty index.
+ * Return NULL if could not allocate space.
+ */
+hindex_t *hindex_new();
+
+/* Free the index.  No effect if h is NULL */
+void hindex_free(hindex_t *h);
+
+/*
+ * Count one more occurrence of the len bytes of s.
+ * Return false, leaving h as it was, if could not allocate space.
+ */
+bool hindex_add(hindex_t *h, const char *s, size_t len);
+
+/*
+ * Count one more occurrence of the len bytes of s, as hindex_add() does.
+ * Return the offset of the entry of its key, or -1 if could not allocate
+ * space.
+ */
+int64_t hindex_add_key(hindex_t *h, const char *s, size_t len);
+
+/* Count one occurrence less of the len bytes of s, which must be counted */
+void hindex_remove(hindex_t *h, const char *s, size_t len);
+
+/* Return the number of occurrences of the len bytes of s */
+int hindex_count(const hindex_t *h, const char *s, size_t len);
+
+/* Return the number of distinct strings counted */
+size_t hindex_size(const hindex_t *h);
+
+/*
+ * Return the packed entries of the keys, and their size in bytes in
+ * *bytes.  Only meaningful if no string was ever removed.
+ */
+const char *hindex_keys(const hindex_t *h, size_t *bytes);
+
+/* Forget every string */
+void hindex_clear(hindex_t *h);
+
+#endif /* LAB0_HASHINDEX_H */
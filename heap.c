@@ -0,0 +1,239 @@
+/*
+ * Binary heap backend.
+ *
+ * Strings are kept in an array of pointers ordered as a binary min-heap:
+ * the string of slot i is never greater than those of slots 2i+1 and 2i+2.
+ * Insertion at either end pushes the string in O(log n), and the head is
+ * always the smallest string, removed in O(log n).  Walks go through the
+ * array in slot order, which is only sorted after q_sort().
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "backend.h"
+#include "harness.h"
+
+/* Initial number of slots */
+#define HEAP_MIN_CAPACITY 16
+
+typedef struct {
+    char **values;   /* Strings in heap order */
+    size_t capacity; /* Number of slots */
+} heap_t;
+
+static inline void swap_value(char **a, char **b)
+{
+    char *tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+/* Move the string of slot i up until its parent is not greater */
+static void sift_up(char **a, size_t i)
+{
+    char *value = a[i];
+
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (strcmp(a[parent], value) <= 0)
+            break;
+        a[i] = a[parent];
+        i = parent;
+    }
+    a[i] = value;
+}
+
+/*
+ * Move the string of slot i down among the first n slots until none of its
+ * children is smaller.  The hole is carried down without swapping.
+ */
+static void sift_down(char **a, size_t n, size_t i)
+{
+    char *value = a[i];
+
+    for (size_t child; (child = 2 * i + 1) < n; i = child) {
+        if (child + 1 < n && strcmp(a[child + 1], a[child]) < 0)
+            child++;
+        if (strcmp(value, a[child]) <= 0)
+            break;
+        a[i] = a[child];
+    }
+    a[i] = value;
+}
+
+static bool heap_init(queue_t *q)
+{
+    heap_t *h = malloc(sizeof(heap_t));
+    if (!h)
+        return false;
+    h->values = malloc(HEAP_MIN_CAPACITY * sizeof(char *));
+    if (!h->values) {
+        free(h);
+        return false;
+    }
+
+    h->capacity = HEAP_MIN_CAPACITY;
+    q->store = h;
+    return true;
+}
+
+static void heap_release(queue_t *q)
+{
+    heap_t *h = q->store;
+
+    for (size_t i = 0; i < q->size; i++)
+        free(h->values[i]);
+    free(h->values);
+    free(h);
+}
+
+/* Make room for n strings in all, doubling the capacity as needed */
+static bool heap_reserve(queue_t *q, size_t n)
+{
+    heap_t *h = q->store;
+    if (n <= h->capacity)
+        return true;
+
+    size_t capacity = h->capacity;
+    while (capacity < n)
+        capacity *= 2;
+    char **values = malloc(capacity * sizeof(char *));
+    if (!values)
+        return false;
+
+    memcpy(values, h->values, q->size * sizeof(char *));
+    free(h->values);
+    h->values = values;
+    h->capacity = capacity;
+    return true;
+}
+
+/* Both ends push the string to its place in the heap */
+static bool heap_push(queue_t *q, const char *s, size_t len)
+{
+    heap_t *h = q->store;
+
+    if (!heap_reserve(q, q->size + 1))
+        return false;
+    char *value = backend_copy_string(s, len);
+    if (!value)
+        return false;
+
+    h->values[q->size] = value;
+    sift_up(h->values, q->size);
+    q->size++;
+    return true;
+}
+
+/* Remove the smallest string, filling its slot from the last one */
+static char *heap_take_head(queue_t *q)
+{
+    heap_t *h = q->store;
+    char *value = h->values[0];
+
+    q->size--;
+    if (q->size) {
+        h->values[0] = h->values[q->size];
+        sift_down(h->values, q->size, 0);
+    }
+    return value;
+}
+
+/* The last slot is a leaf, whose removal leaves the heap in order */
+static char *heap_take_tail(queue_t *q)
+{
+    heap_t *h = q->store;
+
+    q->size--;
+    return h->values[q->size];
+}
+
+static char *heap_peek_head(queue_t *q)
+{
+    heap_t *h = q->store;
+    return h->values[0];
+}
+
+/* The order of a heap follows from its strings, so reversing has no effect */
+static void heap_reverse(queue_t *q) {}
+
+/*
+ * Heap sort in place: popping the smallest string into the slot freed at
+ * the end leaves the array in descending order, which is then reversed.
+ * The sorted array is still a valid heap.
+ */
+static void heap_sort(queue_t *q)
+{
+    heap_t *h = q->store;
+    char **a = h->values;
+
+    for (size_t n = q->size - 1; n > 0; n--) {
+        swap_value(&a[0], &a[n]);
+        sift_down(a, n, 0);
+    }
+    for (size_t i = 0, j = q->size - 1; i < j; i++, j--)
+        swap_value(&a[i], &a[j]);
+}
+
+/* Push the n strings of src from slot i into dst */
+static void heap_move(queue_t *dst, queue_t *src, size_t i, size_t n)
+{
+    heap_t *d = dst->store, *s = src->store;
+
+    for (size_t k = 0; k < n; k++) {
+        d->values[dst->size] = s->values[i + k];
+        sift_up(d->values, dst->size);
+        dst->size++;
+    }
+    src->size -= n;
+}
+
+static bool heap_concat(queue_t *dst, queue_t *src)
+{
+    if (!heap_reserve(dst, dst->size + src->size))
+        return false;
+
+    heap_move(dst, src, 0, src->size);
+    return true;
+}
+
+/* The first n slots of a heap form a heap of their own */
+static bool heap_split(queue_t *q, int n, queue_t *out)
+{
+    if (!heap_reserve(out, out->size + q->size - n))
+        return false;
+
+    heap_move(out, q, n, q->size - n);
+    return true;
+}
+
+static void heap_iter_init(q_iter_t *it)
+{
+    it->index = 0;
+}
+
+static char *heap_iter_next(q_iter_t *it)
+{
+    heap_t *h = it->q->store;
+
+    if (it->index == it->q->size)
+        return NULL;
+    return h->values[it->index++];
+}
+
+const backend_t heap_backend = {
+    .init = heap_init,
+    .release = heap_release,
+    .insert_head = heap_push,
+    .insert_tail = heap_push,
+    .take_head = heap_take_head,
+    .take_tail = heap_take_tail,
+    .peek_head = heap_peek_head,
+    .reverse = heap_reverse,
+    .sort = heap_sort,
+    .concat = heap_concat,
+    .split = heap_split,
+    .iter_init = heap_iter_init,
+    .iter_next = heap_iter_next,
+};
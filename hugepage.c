@@ -0,0 +1,54 @@
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include "hugepage.h"
+
+int huge_pages = 0;
+
+/* Updated from the reclaimer thread as well, see q_async_free */
+static size_t mapped_regions = 0;
+static size_t mapped_bytes = 0;
+
+void *huge_alloc(size_t bytes)
+{
+    /*
+     * mmap() only aligns on small pages.  Map one huge page more than
+     * needed, then trim the excess on both sides of the aligned region.
+     */
+    size_t span = bytes + HUGE_PAGE_SIZE;
+    char *p = mmap(NULL, span, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        return NULL;
+
+    char *region = (char *) HUGE_ROUND((uintptr_t) p);
+    size_t head = region - p, tail = span - head - bytes;
+    if (head)
+        munmap(p, head);
+    if (tail)
+        munmap(region + bytes, tail);
+
+    /* Without transparent huge pages, the region is merely aligned */
+    madvise(region, bytes, MADV_HUGEPAGE);
+
+    __atomic_add_fetch(&mapped_regions, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&mapped_bytes, bytes, __ATOMIC_RELAXED);
+    return region;
+}
+
+void huge_free(void *region, size_t bytes)
+{
+    munmap(region, bytes);
+    __atomic_sub_fetch(&mapped_regions, 1, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&mapped_bytes, bytes, __ATOMIC_RELAXED);
+}
+
+size_t huge_regions()
+{
+    return __atomic_load_n(&mapped_regions, __ATOMIC_RELAXED);
+}
+
+size_t huge_bytes()
+{
+    return __atomic_load_n(&mapped_bytes, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,56 @@
+#ifndef LAB0_HUGEPAGE_H
+#define LAB0_HUGEPAGE_H
+
+/*
+ * Regions backed by transparent huge pages.
+ *
+ * Pools and arenas normally get their chunks from malloc, which spreads a
+ * large queue over many 4 KiB pages: walking it in an order unrelated to
+ * the addresses of its nodes, as after a sort, misses the TLB on nearly
+ * every node.  With huge_pages set, new chunks are mapped instead, aligned
+ * on a huge page and advised with MADV_HUGEPAGE, so one TLB entry covers
+ * 2 MiB of nodes and strings.  Only chunks of HUGE_MIN_CHUNK bytes or
+ * more are mapped, rounded up to whole huge pages.
+ *
+ * The regions do not go through the test harness, so they are counted
+ * here for the leak checks of qtest.
+ */
+
+#include <stddef.h>
+
+/* Size and alignment of a transparent huge page */
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/* Round bytes up to a whole number of huge pages */
+#define HUGE_ROUND(bytes) \
+    (((bytes) + HUGE_PAGE_SIZE - 1) & ~((size_t) HUGE_PAGE_SIZE - 1))
+
+/*
+ * Smallest chunk mapped as a huge region.  Smaller chunks, such as the
+ * first ones of every queue, still come from malloc, so a queue of a few
+ * elements does not take a whole huge page.  With huge_pages set, pools
+ * and arenas grow their chunks until they fill a huge page.
+ */
+#define HUGE_MIN_CHUNK (HUGE_PAGE_SIZE / 2)
+
+/* Whether pools and arenas map their new large chunks as huge regions */
+extern int huge_pages;
+
+/*
+ * Map a region of bytes, which must be a multiple of HUGE_PAGE_SIZE,
+ * aligned on HUGE_PAGE_SIZE.  The kernel is only advised to use huge pages;
+ * the region works the same without them.
+ * Return NULL if could not map it.
+ */
+void *huge_alloc(size_t bytes);
+
+/* Unmap a region of bytes obtained from huge_alloc() */
+void huge_free(void *region, size_t bytes);
+
+/* Number of regions mapped and not yet unmapped */
+size_t huge_regions();
+
+/* Bytes of the regions mapped and not yet unmapped */
+size_t huge_bytes();
+
+#endif /* LAB0_HUGEPAGE_H */
@@ -0,0 +1,129 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "harness.h"
+#include "hashindex.h"
+#include "intern.h"
+
+/* Shared copy of a string, found from its value through container_of */
+typedef struct ENTRY {
+    struct ENTRY *next; /* Next entry in the same bucket */
+    size_t refcnt;
+    size_t len;
+    uint32_t hash;
+    char value[];
+} entry_t;
+
+#define ENTRY_OF(v) ((entry_t *) ((v) - offsetof(entry_t, value)))
+
+/* Buckets at the first insertion, doubled whenever entries outnumber them */
+#define INTERN_MIN_BUCKETS 256
+
+static entry_t **buckets = NULL;
+static size_t nbuckets = 0;
+static intern_stats_t stats;
+
+/* Rehash every entry into a table of n buckets */
+static bool resize(size_t n)
+{
+    entry_t **table = malloc(n * sizeof(entry_t *));
+    if (!table)
+        return false;
+    memset(table, 0, n * sizeof(entry_t *));
+
+    for (size_t i = 0; i < nbuckets; i++) {
+        entry_t *e = buckets[i];
+        while (e) {
+            entry_t *next = e->next;
+            e->next = table[e->hash & (n - 1)];
+            table[e->hash & (n - 1)] = e;
+            e = next;
+        }
+    }
+
+    free(buckets);
+    buckets = table;
+    nbuckets = n;
+    return true;
+}
+
+char *intern_get(const char *s, size_t len)
+{
+    uint32_t hash = hash_string(s, len);
+
+    if (nbuckets) {
+        for (entry_t *e = buckets[hash & (nbuckets - 1)]; e; e = e->next) {
+            if (e->hash == hash && e->len == len &&
+                !memcmp(e->value, s, len)) {
+                intern_hold(e->value);
+                return e->value;
+            }
+        }
+    }
+
+    /* Growing is best effort, a crowded table still works */
+    if (stats.unique >= nbuckets)
+        resize(nbuckets ? 2 * nbuckets : INTERN_MIN_BUCKETS);
+    if (!nbuckets)
+        return NULL;
+
+    entry_t *e = malloc(sizeof(entry_t) + len + 1);
+    if (!e)
+        return NULL;
+    e->refcnt = 1;
+    e->len = len;
+    e->hash = hash;
+    memcpy(e->value, s, len);
+    e->value[len] = '\0';
+
+    e->next = buckets[hash & (nbuckets - 1)];
+    buckets[hash & (nbuckets - 1)] = e;
+
+    stats.unique++;
+    stats.references++;
+    stats.stored_bytes += len + 1;
+    stats.logical_bytes += len + 1;
+    return e->value;
+}
+
+void intern_hold(char *value)
+{
+    entry_t *e = ENTRY_OF(value);
+
+    e->refcnt++;
+    stats.references++;
+    stats.logical_bytes += e->len + 1;
+}
+
+void intern_put(char *value)
+{
+    entry_t *e = ENTRY_OF(value);
+
+    stats.references--;
+    stats.logical_bytes -= e->len + 1;
+    if (--e->refcnt)
+        return;
+
+    /* Last reference, unlink the entry from its bucket */
+    entry_t **p = &buckets[e->hash & (nbuckets - 1)];
+    while (*p != e)
+        p = &(*p)->next;
+    *p = e->next;
+
+    stats.unique--;
+    stats.stored_bytes -= e->len + 1;
+    free(e);
+
+    /* An empty table keeps nothing allocated */
+    if (!stats.unique) {
+        free(buckets);
+        buckets = NULL;
+        nbuckets = 0;
+    }
+}
+
+void intern_stats(intern_stats_t *st)
+{
+    *st = stats;
+}
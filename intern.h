@@ -0,0 +1,41 @@
+#ifndef LAB0_INTERN_H
+#define LAB0_INTERN_H
+
+/*
+ * String intern table.
+ *
+ * Equal strings are stored once and shared by reference counting, which is
+ * what INTERN_LAYOUT queues use for the values of their elements.  The
+ * table is shared by every queue, and all of its memory comes from malloc
+ * so the test harness accounts for it.  Once the last reference is
+ * dropped the table releases everything, including its buckets.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Counters describing the content of the table */
+typedef struct {
+    size_t unique;        /* Distinct strings stored */
+    size_t references;    /* Outstanding references to them */
+    size_t stored_bytes;  /* Bytes of string data actually stored */
+    size_t logical_bytes; /* Bytes the references would take as copies */
+} intern_stats_t;
+
+/*
+ * Return the shared copy of the len bytes of s, creating it if needed, and
+ * take a reference to it.  The copy is null-terminated.
+ * Return NULL if could not allocate space.
+ */
+char *intern_get(const char *s, size_t len);
+
+/* Take one more reference to a string returned by intern_get() */
+void intern_hold(char *value);
+
+/* Drop a reference to a string returned by intern_get() */
+void intern_put(char *value);
+
+/* Report the current counters of the table */
+void intern_stats(intern_stats_t *st);
+
+#endif /* LAB0_INTERN_H */
@@ -0,0 +1,195 @@
+#ifndef LAB0_LIST_H
+#define LAB0_LIST_H
+
+/*
+ * Intrusive circular doubly-linked list, following the Linux kernel API.
+ *
+ * A struct list_head is embedded in the objects to be linked, and another
+ * one serves as the head of the list.  No memory is allocated by any of
+ * these functions: the caller owns the objects, and container_of() gets
+ * back from a link to the object holding it.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Object of type type holding the member member at address ptr */
+#ifndef container_of
+#define container_of(ptr, type, member) \
+    ((type *) ((char *) (ptr) -offsetof(type, member)))
+#endif
+
+struct list_head {
+    struct list_head *prev;
+    struct list_head *next;
+};
+
+/* Define and initialize an empty list head called name */
+#define LIST_HEAD(name) struct list_head name = {&(name), &(name)}
+
+static inline void INIT_LIST_HEAD(struct list_head *head)
+{
+    head->next = head;
+    head->prev = head;
+}
+
+/* Link node between the consecutive entries prev and next */
+static inline void __list_add(struct list_head *node,
+                              struct list_head *prev,
+                              struct list_head *next)
+{
+    next->prev = node;
+    node->next = next;
+    node->prev = prev;
+    prev->next = node;
+}
+
+/* Insert node right after head, at the start of the list */
+static inline void list_add(struct list_head *node, struct list_head *head)
+{
+    __list_add(node, head, head->next);
+}
+
+/* Insert node right before head, at the end of the list */
+static inline void list_add_tail(struct list_head *node,
+                                 struct list_head *head)
+{
+    __list_add(node, head->prev, head);
+}
+
+/* Unlink node from its list.  Its own links are left dangling. */
+static inline void list_del(struct list_head *node)
+{
+    node->next->prev = node->prev;
+    node->prev->next = node->next;
+}
+
+/* Unlink node from its list and make it an empty list of its own */
+static inline void list_del_init(struct list_head *node)
+{
+    list_del(node);
+    INIT_LIST_HEAD(node);
+}
+
+static inline bool list_empty(const struct list_head *head)
+{
+    return head->next == head;
+}
+
+static inline bool list_is_singular(const struct list_head *head)
+{
+    return !list_empty(head) && head->prev == head->next;
+}
+
+/* Link the entries of list, which must not be empty, between prev, next */
+static inline void __list_splice(const struct list_head *list,
+                                 struct list_head *prev,
+                                 struct list_head *next)
+{
+    struct list_head *first = list->next, *last = list->prev;
+
+    first->prev = prev;
+    prev->next = first;
+    last->next = next;
+    next->prev = last;
+}
+
+/*
+ * Move the entries of list to the start of head.  The links of list are
+ * left dangling, so it must not be used as a list again before it is
+ * initialized.
+ */
+static inline void list_splice(const struct list_head *list,
+                               struct list_head *head)
+{
+    if (!list_empty(list))
+        __list_splice(list, head, head->next);
+}
+
+/* Move the entries of list to the end of head, see list_splice() */
+static inline void list_splice_tail(const struct list_head *list,
+                                    struct list_head *head)
+{
+    if (!list_empty(list))
+        __list_splice(list, head->prev, head);
+}
+
+/* Move the entries of list to the start of head, leaving list empty */
+static inline void list_splice_init(struct list_head *list,
+                                    struct list_head *head)
+{
+    list_splice(list, head);
+    INIT_LIST_HEAD(list);
+}
+
+/* Move the entries of list to the end of head, leaving list empty */
+static inline void list_splice_tail_init(struct list_head *list,
+                                         struct list_head *head)
+{
+    list_splice_tail(list, head);
+    INIT_LIST_HEAD(list);
+}
+
+/*
+ * Move the entries of head up to and including entry, which must be one of
+ * them, to list, which must be empty.  Nothing moves if entry is head.
+ */
+static inline void list_cut_position(struct list_head *list,
+                                     struct list_head *head,
+                                     struct list_head *entry)
+{
+    if (entry == head)
+        return;
+
+    struct list_head *first = head->next;
+
+    list->next = first;
+    first->prev = list;
+    list->prev = entry;
+    head->next = entry->next;
+    entry->next->prev = head;
+    entry->next = list;
+}
+
+#define list_entry(node, type, member) container_of(node, type, member)
+
+#define list_first_entry(head, type, member) \
+    list_entry((head)->next, type, member)
+
+#define list_last_entry(head, type, member) \
+    list_entry((head)->prev, type, member)
+
+/* Walk the links of head; node must not be removed from the list */
+#define list_for_each(node, head) \
+    for (node = (head)->next; node != (head); node = node->next)
+
+/* Walk the links of head, allowing node to be removed on the way */
+#define list_for_each_safe(node, safe, head)                     \
+    for (node = (head)->next, safe = node->next; node != (head); \
+         node = safe, safe = node->next)
+
+/* Walk the objects of type __typeof__(*entry) linked into head */
+#define list_for_each_entry(entry, head, member)                     \
+    for (entry = list_entry((head)->next, __typeof__(*entry), member); \
+         &entry->member != (head);                                     \
+         entry = list_entry(entry->member.next, __typeof__(*entry), member))
+
+/* Same as list_for_each_entry(), allowing entry to be removed on the way */
+#define list_for_each_entry_safe(entry, safe, head, member)              \
+    for (entry = list_entry((head)->next, __typeof__(*entry), member),   \
+        safe = list_entry(entry->member.next, __typeof__(*entry), member); \
+         &entry->member != (head); entry = safe,                          \
+        safe = list_entry(safe->member.next, __typeof__(*entry), member))
+
+/* Comparison of the objects holding a and b, returning like strcmp() */
+typedef int (*list_cmp_func_t)(void *priv,
+                               const struct list_head *a,
+                               const struct list_head *b);
+
+/*
+ * Sort the entries of head in ascending order of cmp, which is handed priv
+ * on every call.  The sort is stable, and allocates no memory.
+ */
+void list_sort(void *priv, struct list_head *head, list_cmp_func_t cmp);
+
+#endif /* LAB0_LIST_H */
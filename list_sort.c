@@ -0,0 +1,99 @@
+#include "list.h"
+
+/* Merge two sorted chains linked through next, keeping a first on ties */
+static struct list_head *merge(void *priv,
+                               list_cmp_func_t cmp,
+                               struct list_head *a,
+                               struct list_head *b)
+{
+    struct list_head *head = NULL, **tail = &head;
+
+    while (a && b) {
+        struct list_head **min = cmp(priv, b, a) < 0 ? &b : &a;
+        *tail = *min;
+        tail = &(*min)->next;
+        *min = (*min)->next;
+    }
+    *tail = a ? a : b;
+    return head;
+}
+
+/*
+ * Last merge, of a and b into head, which also rebuilds the prev links and
+ * closes the circle.
+ */
+static void merge_final(void *priv,
+                        list_cmp_func_t cmp,
+                        struct list_head *head,
+                        struct list_head *a,
+                        struct list_head *b)
+{
+    struct list_head *tail = head;
+
+    while (a && b) {
+        struct list_head **min = cmp(priv, b, a) < 0 ? &b : &a;
+        tail->next = *min;
+        (*min)->prev = tail;
+        tail = *min;
+        *min = (*min)->next;
+    }
+    for (struct list_head *node = a ? a : b; node; node = node->next) {
+        tail->next = node;
+        node->prev = tail;
+        tail = node;
+    }
+    tail->next = head;
+    head->prev = tail;
+}
+
+/*
+ * Merge sort after list_sort() of the Linux kernel.  Entries move one at a
+ * time onto a stack of pending runs, each a chain of next links, chained
+ * to the run before it through the prev link of its first entry.  When
+ * count entries have moved, its trailing one bits tell how many runs to
+ * skip from the newest one; if count has another bit set above them, the
+ * two runs there, of equal size, are merged.  That merges two runs of 2^k
+ * only once 2^k more entries have followed them, so every merge is at
+ * worst 2:1 unbalanced while its runs were recently touched and still in
+ * cache.
+ */
+void list_sort(void *priv, struct list_head *head, list_cmp_func_t cmp)
+{
+    struct list_head *list = head->next, *pending = NULL;
+    size_t count = 0;
+
+    if (list == head->prev)
+        return;
+
+    head->prev->next = NULL;
+    do {
+        struct list_head **run = &pending;
+        size_t bits = count;
+        for (; bits & 1; bits >>= 1)
+            run = &(*run)->prev;
+
+        /* Older run on the left keeps the sort stable */
+        if (bits) {
+            struct list_head *newer = *run, *older = newer->prev;
+            struct list_head *merged = merge(priv, cmp, older, newer);
+            merged->prev = older->prev;
+            *run = merged;
+        }
+
+        list->prev = pending;
+        pending = list;
+        list = list->next;
+        pending->next = NULL;
+        count++;
+    } while (list);
+
+    /* Merge every run into the newest, leaving the oldest for the end */
+    list = pending;
+    pending = pending->prev;
+    while (pending->prev) {
+        struct list_head *older = pending->prev;
+        list = merge(priv, cmp, pending, list);
+        pending = older;
+    }
+    merge_final(priv, cmp, head, pending, list);
+}
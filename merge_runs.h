@@ -0,0 +1,77 @@
+#ifndef LAB0_MERGE_RUNS_H
+#define LAB0_MERGE_RUNS_H
+
+/*
+ * Bottom-up merge sort over the bins of a binary counter, shared by the
+ * sorts of the linked list and of the compact backend.
+ *
+ * The caller takes its nodes off one at a time, in order, and adds each as
+ * a sorted run of one.  bins[i] holds a run of 2^i nodes, and a new run is
+ * merged with the full bins below it like the carry of an increment.  The
+ * bins are the only extra space, whatever the number of nodes.
+ *
+ * Nodes are opaque: a run only records its first and last node, and the
+ * merge function of the caller follows its own links.  Knowing the last
+ * node of every run gives the tail of the result without walking to it.
+ */
+
+#include <stddef.h>
+
+/* Runs longer than 2^63 nodes cannot exist, which bounds the bins */
+#define MERGE_BINS 64
+
+typedef struct {
+    void *head, *tail; /* First and last node, NULL for an empty run */
+} run_t;
+
+/*
+ * Merge two sorted runs, neither empty, into one.  The nodes of a come
+ * before those of b, so a has to win ties for the sort to be stable.
+ */
+typedef run_t (*run_merge_t)(void *priv, run_t a, run_t b);
+
+typedef struct {
+    run_t bins[MERGE_BINS];
+    int max_bin; /* No bin above holds a run */
+    run_merge_t merge;
+    void *priv; /* Handed to merge */
+} merge_bins_t;
+
+static inline void merge_bins_init(merge_bins_t *mb,
+                                   run_merge_t merge,
+                                   void *priv)
+{
+    *mb = (merge_bins_t){.merge = merge, .priv = priv};
+}
+
+/* Add node, the next one in order, as a run of its own */
+static inline void merge_bins_add(merge_bins_t *mb, void *node)
+{
+    run_t carry = {node, node};
+    int i = 0;
+
+    for (; mb->bins[i].head; i++) {
+        carry = mb->merge(mb->priv, mb->bins[i], carry);
+        mb->bins[i].head = NULL;
+    }
+    mb->bins[i] = carry;
+    if (i > mb->max_bin)
+        mb->max_bin = i;
+}
+
+/* Merge the runs left in the bins, and return the sorted result */
+static inline run_t merge_bins_finish(merge_bins_t *mb)
+{
+    run_t sorted = {NULL, NULL};
+
+    /* Runs of the higher bins hold earlier nodes, so they go on the left */
+    for (int i = 0; i <= mb->max_bin; i++) {
+        if (!mb->bins[i].head)
+            continue;
+        sorted = sorted.head ? mb->merge(mb->priv, mb->bins[i], sorted)
+                             : mb->bins[i];
+    }
+    return sorted;
+}
+
+#endif /* LAB0_MERGE_RUNS_H */
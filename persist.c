@@ -0,0 +1,247 @@
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "harness.h"
+#include "hashindex.h"
+#include "persist.h"
+
+#define SAVE_MAGIC "lab0q\0v1"
+
+typedef struct {
+    char magic[8];
+    uint32_t nstrings;    /* Distinct strings in the table */
+    uint32_t nelements;   /* Offsets in the order, one per element */
+    uint64_t table_bytes; /* Size of the table, a multiple of 4 */
+} save_header_t;
+
+/* Number of strings handed to q_insert_tail_n() at once */
+#define LOAD_BATCH 64
+
+/* Bytes read from an imported file at once, and at least held in memory */
+#define IMPORT_CHUNK (1 << 20)
+
+bool q_save(queue_t *q, const char *path)
+{
+    if (!q)
+        return false;
+
+    /* Strings are added but never removed, so they form the table as is */
+    int n = q_size(q);
+    hindex_t *table = hindex_new();
+    uint32_t *order = malloc((n ? n : 1) * sizeof(uint32_t));
+
+    bool ok = table && order;
+    if (ok) {
+        q_iter_t it;
+        q_iter_init(q, &it);
+        for (int i = 0; ok && i < n; i++) {
+            const char *s = q_iter_next(&it);
+            int64_t off = hindex_add_key(table, s, strlen(s));
+            ok = off >= 0;
+            order[i] = off;
+        }
+    }
+
+    FILE *f = ok ? fopen(path, "wb") : NULL;
+    if (f) {
+        size_t bytes;
+        const char *keys = hindex_keys(table, &bytes);
+        save_header_t h = {
+            .nstrings = hindex_size(table),
+            .nelements = n,
+            .table_bytes = bytes,
+        };
+        memcpy(h.magic, SAVE_MAGIC, sizeof(h.magic));
+        ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+             fwrite(keys, 1, bytes, f) == bytes &&
+             fwrite(order, sizeof(uint32_t), n, f) == (size_t) n;
+        ok = !fclose(f) && ok;
+    } else {
+        ok = false;
+    }
+
+    hindex_free(table);
+    free(order);
+    return ok;
+}
+
+/*
+ * Return the string at offset off of a table of bytes, or NULL if the
+ * entry does not lie within the table.
+ */
+static char *table_entry(char *table, uint64_t bytes, uint32_t off)
+{
+    if (off % sizeof(uint32_t) || off + sizeof(uint32_t) > bytes)
+        return NULL;
+
+    uint32_t len = *(uint32_t *) (table + off);
+    char *s = table + off + sizeof(uint32_t);
+    if (off + HINDEX_ENTRY_SIZE(len) > bytes || s[len])
+        return NULL;
+    return s;
+}
+
+/* Fill q with the elements saved in a mapped file, checked by q_load() */
+static bool load_elements(queue_t *q, save_header_t *h)
+{
+    char *table = (char *) (h + 1);
+    uint32_t *order = (uint32_t *) (table + h->table_bytes);
+    char *batch[LOAD_BATCH];
+
+    for (uint32_t i = 0; i < h->nelements;) {
+        int n = 0;
+        for (; n < LOAD_BATCH && i < h->nelements; n++, i++) {
+            batch[n] = table_entry(table, h->table_bytes, order[i]);
+            if (!batch[n])
+                return false;
+        }
+        if (q_insert_tail_n(q, batch, n) != n)
+            return false;
+    }
+    return true;
+}
+
+queue_t *q_load(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) || (size_t) st.st_size < sizeof(save_header_t)) {
+        close(fd);
+        return NULL;
+    }
+    size_t size = st.st_size;
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return NULL;
+
+    save_header_t *h = map;
+    queue_t *q = NULL;
+    if (!memcmp(h->magic, SAVE_MAGIC, sizeof(h->magic)) &&
+        h->table_bytes % sizeof(uint32_t) == 0 &&
+        h->table_bytes <= size - sizeof(save_header_t) &&
+        (size - sizeof(save_header_t) - h->table_bytes) / sizeof(uint32_t) ==
+            h->nelements &&
+        h->nelements <= INT32_MAX)
+        q = q_new();
+
+    if (q && !load_elements(q, h)) {
+        q_free(q);
+        q = NULL;
+    }
+
+    munmap(map, size);
+    return q;
+}
+
+/* Strings of an import waiting to be inserted together */
+typedef struct {
+    queue_t *q;
+    bool head;
+    char *sv[LOAD_BATCH];
+    int n;
+    int count; /* Strings inserted so far */
+} import_t;
+
+/* Insert the strings waiting in im, return false if not all of them fit */
+static bool import_flush(import_t *im)
+{
+    int n = im->head ? q_insert_head_n(im->q, im->sv, im->n)
+                     : q_insert_tail_n(im->q, im->sv, im->n);
+    im->count += n;
+    bool ok = n == im->n;
+    im->n = 0;
+    return ok;
+}
+
+/*
+ * Terminate the lines in the len bytes at buf and queue them for insertion,
+ * inserting them all before returning.  The line at the end is left alone,
+ * unless last is set, since the rest of it has not been read yet.
+ * Return the number of bytes handled, or -1 if an insertion failed.
+ */
+static ssize_t import_lines(import_t *im, char *buf, size_t len, bool last)
+{
+    char *p = buf, *end = buf + len;
+
+    for (;;) {
+        char *nl = memchr(p, '\n', end - p);
+        if (!nl && (!last || p == end))
+            break;
+        if (!nl)
+            nl = end;
+
+        char *stop = nl > p && nl[-1] == '\r' ? nl - 1 : nl;
+        if (stop > p) {
+            *stop = '\0';
+            im->sv[im->n++] = p;
+            if (im->n == LOAD_BATCH && !import_flush(im))
+                return -1;
+        }
+        p = nl < end ? nl + 1 : end;
+    }
+
+    /* The strings point into buf, which is about to be overwritten */
+    if (im->n && !import_flush(im))
+        return -1;
+    return p - buf;
+}
+
+int q_import(queue_t *q, const char *path, bool head)
+{
+    if (!q)
+        return -1;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    import_t im = {.q = q, .head = head};
+    size_t cap = IMPORT_CHUNK, used = 0;
+    char *buf = malloc(cap);
+    bool ok = buf;
+
+    while (ok) {
+        /* A line longer than the buffer needs a larger one */
+        if (used == cap) {
+            char *bigger = malloc(2 * cap);
+            if (!bigger) {
+                ok = false;
+                break;
+            }
+            memcpy(bigger, buf, used);
+            free(buf);
+            buf = bigger;
+            cap *= 2;
+        }
+
+        ssize_t got = read(fd, buf + used, cap - used);
+        if (got < 0) {
+            ok = false;
+            break;
+        }
+        used += got;
+
+        ssize_t done = import_lines(&im, buf, used, !got);
+        if (done < 0 || !got) {
+            ok = done >= 0;
+            break;
+        }
+        memmove(buf, buf + done, used - done);
+        used -= done;
+    }
+
+    free(buf);
+    close(fd);
+    return ok ? im.count : -1;
+}
@@ -0,0 +1,53 @@
+#ifndef LAB0_PERSIST_H
+#define LAB0_PERSIST_H
+
+/*
+ * Saving a queue to a binary file, and loading it back.
+ *
+ * The file holds a header, a table of the distinct strings, and the order
+ * of the elements as offsets into that table:
+ *
+ *   header   magic, number of strings, of elements, size of the table
+ *   table    per string: 32-bit length, bytes, null terminator, padding
+ *            up to a multiple of 4
+ *   order    per element, from head to tail: 32-bit offset of its string
+ *
+ * Numbers are in the byte order of the machine that saved the file.  Every
+ * string in the table is already null-terminated, so a mapped file is used
+ * as it is, without parsing beyond bounds checks.
+ *
+ * Plain text files, one string per line, are imported with q_import().
+ */
+
+#include <stdbool.h>
+
+#include "queue.h"
+
+/*
+ * Save the strings of queue, from head to tail, to the file at path.
+ * Return true if successful.
+ * Return false if q is NULL, could not allocate space, or the file could
+ * not be written.
+ */
+bool q_save(queue_t *q, const char *path);
+
+/*
+ * Create a queue, as q_new() does, holding the strings saved at path.
+ * Return NULL if the file could not be mapped, is not a valid save, or
+ * could not allocate space.
+ */
+queue_t *q_load(const char *path);
+
+/*
+ * Insert every line of the text file at path into queue, at its tail, or
+ * at its head if head is true, as one q_insert_tail() or q_insert_head()
+ * per line would.  The file is read in large chunks, so it may be a pipe.
+ * A line ends at a newline, which is not stored, nor a carriage return
+ * before it.  Empty lines are skipped.
+ * Return the number of strings inserted.
+ * Return -1 if q is NULL, the file could not be read, or could not
+ * allocate space; the lines before the failure are inserted.
+ */
+int q_import(queue_t *q, const char *path, bool head);
+
+#endif /* LAB0_PERSIST_H */
@@ -0,0 +1,153 @@
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "harness.h"
+#include "hugepage.h"
+#include "pool.h"
+
+/* Every object is aligned like a pointer-sized field */
+#define POOL_ALIGN sizeof(void *)
+
+/* Chunk growth: start small, double on every refill up to the limit */
+#define POOL_MIN_CHUNK_OBJS 64
+#define POOL_MAX_CHUNK_OBJS 16384
+
+/* Allocate a new chunk and make it the source of never-used objects */
+static bool pool_refill(pool_t *p)
+{
+    size_t bytes = sizeof(pool_chunk_t) + p->chunk_objs * p->obj_size;
+    bool huge = huge_pages && bytes >= HUGE_MIN_CHUNK;
+    pool_chunk_t *chunk;
+    if (huge) {
+        bytes = HUGE_ROUND(bytes);
+        chunk = huge_alloc(bytes);
+    } else {
+        chunk = malloc(bytes);
+    }
+    if (!chunk)
+        return false;
+
+    if (!p->chunks)
+        p->oldest = chunk;
+    chunk->next = p->chunks;
+    chunk->bytes = bytes;
+    chunk->mapped = huge ? bytes : 0;
+    p->chunks = chunk;
+    p->cursor = (char *) (chunk + 1);
+    /* A huge region holds as many whole objects as fit */
+    size_t objs = (bytes - sizeof(pool_chunk_t)) / p->obj_size;
+    p->limit = p->cursor + objs * p->obj_size;
+
+    /* With huge pages, keep growing until a chunk fills one */
+    if (p->chunk_objs < POOL_MAX_CHUNK_OBJS ||
+        (huge_pages && bytes < HUGE_PAGE_SIZE))
+        p->chunk_objs <<= 1;
+    return true;
+}
+
+bool pool_init(pool_t *p, size_t obj_size)
+{
+    if (obj_size < sizeof(pool_slot_t))
+        obj_size = sizeof(pool_slot_t);
+    p->obj_size = (obj_size + POOL_ALIGN - 1) & ~(POOL_ALIGN - 1);
+    p->chunk_objs = POOL_MIN_CHUNK_OBJS;
+    p->chunks = NULL;
+    p->oldest = NULL;
+    p->freelist = NULL;
+    p->last = NULL;
+    p->cursor = NULL;
+    p->limit = NULL;
+
+    /*
+     * Have the first chunk ready up front, so the first insertion into a
+     * queue costs the same as any later one.
+     */
+    return pool_refill(p);
+}
+
+void *pool_alloc(pool_t *p)
+{
+    if (p->freelist) {
+        pool_slot_t *slot = p->freelist;
+        p->freelist = slot->next;
+        return slot;
+    }
+
+    if (p->cursor == p->limit && !pool_refill(p))
+        return NULL;
+
+    void *obj = p->cursor;
+    p->cursor += p->obj_size;
+    return obj;
+}
+
+void pool_free(pool_t *p, void *obj)
+{
+    pool_slot_t *slot = obj;
+    if (!p->freelist)
+        p->last = slot;
+    slot->next = p->freelist;
+    p->freelist = slot;
+}
+
+bool pool_owns(const pool_t *p, const void *ptr)
+{
+    uintptr_t addr = (uintptr_t) ptr;
+
+    for (const pool_chunk_t *chunk = p->chunks; chunk; chunk = chunk->next) {
+        uintptr_t start = (uintptr_t) chunk;
+        if (start <= addr && addr < start + chunk->bytes)
+            return true;
+    }
+    return false;
+}
+
+void pool_merge(pool_t *dst, pool_t *src)
+{
+    if (!src->chunks)
+        return;
+
+    src->oldest->next = dst->chunks;
+    if (!dst->chunks)
+        dst->oldest = src->oldest;
+    dst->chunks = src->chunks;
+
+    if (src->freelist) {
+        src->last->next = dst->freelist;
+        if (!dst->freelist)
+            dst->last = src->last;
+        dst->freelist = src->freelist;
+    }
+
+    /* Only one chunk can be bumped from, keep the one with more room */
+    if (src->limit - src->cursor > dst->limit - dst->cursor) {
+        dst->cursor = src->cursor;
+        dst->limit = src->limit;
+    }
+    if (src->chunk_objs > dst->chunk_objs)
+        dst->chunk_objs = src->chunk_objs;
+
+    src->chunks = NULL;
+    src->oldest = NULL;
+    src->freelist = NULL;
+    src->last = NULL;
+    src->cursor = NULL;
+    src->limit = NULL;
+}
+
+void pool_destroy(pool_t *p)
+{
+    while (p->chunks) {
+        pool_chunk_t *next = p->chunks->next;
+        if (p->chunks->mapped)
+            huge_free(p->chunks, p->chunks->mapped);
+        else
+            free(p->chunks);
+        p->chunks = next;
+    }
+    p->oldest = NULL;
+    p->freelist = NULL;
+    p->last = NULL;
+    p->cursor = NULL;
+    p->limit = NULL;
+}
@@ -0,0 +1,71 @@
+#ifndef LAB0_POOL_H
+#define LAB0_POOL_H
+
+/*
+ * Fixed-size object pool.
+ *
+ * Objects are carved out of chunks obtained from malloc, so every chunk is
+ * still accounted for by the test harness, unless huge_pages maps them (see
+ * hugepage.h).  Released objects go onto a freelist and are handed out again
+ * before a new chunk is requested.  Chunks are only given back to the
+ * allocator by pool_destroy().
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Header placed in front of every chunk owned by a pool */
+typedef struct CHUNK {
+    struct CHUNK *next;
+    size_t bytes;  /* Size of the chunk, header included */
+    size_t mapped; /* Bytes of the huge region holding it, 0 if malloc'd */
+} pool_chunk_t;
+
+/* Object on the freelist, overlaid on the released object itself */
+typedef struct SLOT {
+    struct SLOT *next;
+} pool_slot_t;
+
+typedef struct {
+    size_t obj_size;       /* Size of each object, rounded for alignment */
+    size_t chunk_objs;     /* Number of objects in the next chunk */
+    pool_chunk_t *chunks;  /* Every chunk allocated so far */
+    pool_chunk_t *oldest;  /* Last chunk of the list, to merge in O(1) */
+    pool_slot_t *freelist; /* Released objects ready for reuse */
+    pool_slot_t *last;     /* Last slot of the freelist, if not empty */
+    char *cursor;          /* Next never-used object in the newest chunk */
+    char *limit;           /* End of the newest chunk */
+} pool_t;
+
+/*
+ * Prepare an empty pool handing out objects of obj_size bytes.
+ * Return false if the first chunk could not be allocated.
+ */
+bool pool_init(pool_t *p, size_t obj_size);
+
+/*
+ * Get one object from the pool.
+ * Return NULL if the pool is empty and a new chunk could not be allocated.
+ */
+void *pool_alloc(pool_t *p);
+
+/* Return an object obtained from pool_alloc() to the pool */
+void pool_free(pool_t *p, void *obj);
+
+/*
+ * Return whether ptr points into one of the chunks of the pool.
+ * Takes time linear in the number of chunks.
+ */
+bool pool_owns(const pool_t *p, const void *ptr);
+
+/*
+ * Move every chunk of src, with its objects, into dst, leaving src empty,
+ * in O(1).  Both pools must hand out objects of the same size.  Objects
+ * obtained from src are then returned to dst.
+ */
+void pool_merge(pool_t *dst, pool_t *src);
+
+/* Release every chunk of the pool.  All objects become invalid. */
+void pool_destroy(pool_t *p);
+
+#endif /* LAB0_POOL_H */
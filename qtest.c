@@ -1,5 +1,6 @@
 /* Implementation of testing code for queue code */
 
+#include <errno.h>
 #include <getopt.h>
 #include <signal.h>
 #include <spawn.h>
@@ -32,6 +33,9 @@
 #include "queue.h"
 
 #include "console.h"
+#include "hugepage.h"
+#include "intern.h"
+#include "persist.h"
 #include "report.h"
 
 /* Settable parameters */
@@ -54,12 +58,43 @@ static queue_t *q = NULL;
 /* Number of elements in queue */
 static size_t qcnt = 0;
 
+/*
+ * Every queue by name.  The one being tested lives in q and qcnt, and is
+ * stored back into its slot when another queue is selected.
+ */
+#define MAX_QUEUES 16
+#define QUEUE_NAME_LEN 16
+typedef struct {
+    char name[QUEUE_NAME_LEN];
+    queue_t *q;
+    size_t qcnt;
+} named_queue_t;
+
+static named_queue_t queues[MAX_QUEUES] = {{.name = "main"}};
+static int nqueues = 1;
+static int cur_queue = 0;
+
+/* Snapshots by name, with the number of strings they were taken with */
+#define MAX_SNAPSHOTS 16
+typedef struct {
+    char name[QUEUE_NAME_LEN];
+    q_snapshot_t *s;
+    int size;
+} named_snapshot_t;
+
+static named_snapshot_t snapshots[MAX_SNAPSHOTS];
+static int nsnapshots = 0;
+
 /* How many times can queue operations fail */
 static int fail_limit = BIG_QUEUE;
 static int fail_count = 0;
 
 static int string_length = MAXSTRING;
 
+/* Element layout and backend of queues created by the new command */
+static int layout = POOL_LAYOUT;
+static int backend = LIST_BACKEND;
+
 #define MIN_RANDSTR_LEN 5
 #define MAX_RANDSTR_LEN 10
 static const char charset[] = "abcdefghijklmnopqrstuvwxyz";
@@ -72,10 +107,36 @@ static bool do_insert_head(int argc, char *argv[]);
 static bool do_insert_tail(int argc, char *argv[]);
 static bool do_remove_head(int argc, char *argv[]);
 static bool do_remove_head_quiet(int argc, char *argv[]);
+static bool do_remove_tail(int argc, char *argv[]);
+static bool do_remove_head_take(int argc, char *argv[]);
+static bool do_push(int argc, char *argv[]);
+static bool do_pop_min(int argc, char *argv[]);
+static bool do_remove_head_take_quiet(int argc, char *argv[]);
 static bool do_reverse(int argc, char *argv[]);
+static bool do_relayout(int argc, char *argv[]);
 static bool do_size(int argc, char *argv[]);
+static bool do_nth(int argc, char *argv[]);
+static bool do_rank(int argc, char *argv[]);
+static bool do_range(int argc, char *argv[]);
+static bool do_index(int argc, char *argv[]);
+static bool do_contains(int argc, char *argv[]);
+static bool do_count(int argc, char *argv[]);
 static bool do_sort(int argc, char *argv[]);
 static bool do_show(int argc, char *argv[]);
+static bool do_stats(int argc, char *argv[]);
+static bool do_stat(int argc, char *argv[]);
+static bool do_queue(int argc, char *argv[]);
+static bool do_concat(int argc, char *argv[]);
+static bool do_split(int argc, char *argv[]);
+static bool do_snap(int argc, char *argv[]);
+static bool do_snapshow(int argc, char *argv[]);
+static bool do_snapdrop(int argc, char *argv[]);
+static bool do_save(int argc, char *argv[]);
+static bool do_load(int argc, char *argv[]);
+static bool do_import(int argc, char *argv[]);
+static bool do_rm(int argc, char *argv[]);
+static bool other_queues();
+static bool leak_check();
 
 static void queue_init();
 
@@ -94,20 +155,103 @@ static void console_init()
             "to expected value str");
     add_cmd(
         "rhq", do_remove_head_quiet,
-        "                | Remove from head of queue without reporting value.");
+        " [n]            | Remove from head of queue n times without reporting "
+        "value. (default: n == 1)");
+    add_cmd("rt", do_remove_tail,
+            " [str]          | Remove from tail of queue.  Optionally compare "
+            "to expected value str");
+    add_cmd("rht", do_remove_head_take,
+            " [str]          | Remove from head of queue without copying the "
+            "value.  Optionally compare to expected value str");
+    add_cmd("rhtq", do_remove_head_take_quiet,
+            "                | Remove from head of queue without copying or "
+            "reporting value.");
+    add_cmd("push", do_push,
+            " str [n]        | Push string str into heap queue n times. "
+            "Generate random string(s) if str equals RAND. (default: n == 1)");
+    add_cmd("popmin", do_pop_min,
+            " [str]          | Remove smallest string from heap queue.  "
+            "Optionally compare to expected value str");
     add_cmd("reverse", do_reverse, "                | Reverse queue");
+    add_cmd("relayout", do_relayout,
+            "                | Lay elements out in memory in queue order");
     add_cmd("sort", do_sort,
             " [index]        | Sort queue in ascending order, where index"
-            " == 0 (default: merge sort), 1 (selection sort), 2 (bubble sort)");
+            " == 0 (default: merge sort), 1 (selection sort), 2 (bubble "
+            "sort), 3 (list sort)");
     add_cmd("size", do_size,
             " [n]            | Compute queue size n times (default: n == 1)");
+    add_cmd("nth", do_nth,
+            " n [str]        | Show string at index n of queue.  Optionally "
+            "compare to expected value str");
+    add_cmd("rank", do_rank,
+            " str [n]        | Count the strings of queue less than str.  "
+            "Optionally compare to expected count n");
+    add_cmd("range", do_range,
+            " lo hi [str...] | Show the strings of sorted queue from lo to "
+            "hi.  Optionally compare to expected strings");
+    add_cmd("index", do_index,
+            " [on]           | Index the strings of queue by hash, or drop the "
+            "index if on == 0 (default: on == 1)");
+    add_cmd("contains", do_contains,
+            " str [0|1]      | Tell whether queue holds string str.  "
+            "Optionally compare to expected answer");
+    add_cmd("count", do_count,
+            " str [n]        | Count the strings of queue equal to str.  "
+            "Optionally compare to expected count n");
     add_cmd("show", do_show, "                | Show queue contents");
+    add_cmd("stats", do_stats,
+            "                | Show memory used per element, and saved by "
+            "interned strings");
+    add_cmd("stat", do_stat,
+            " name [n]       | Show counter name, one of unique, references, "
+            "stored, logical, blocks, bytes, dead and regions.  Optionally "
+            "compare to expected value n");
+    add_cmd("queue", do_queue,
+            " [name]         | Test queue name from now on, or list queues. "
+            "A new name starts without queue (default: main)");
+    add_cmd("concat", do_concat,
+            " name           | Move all elements of queue name to the tail of "
+            "queue");
+    add_cmd("split", do_split,
+            " n name         | Keep the first n elements of queue, moving the "
+            "others to the tail of queue name");
+    add_cmd("snap", do_snap,
+            " [name]         | Take snapshot name of queue, or list snapshots");
+    add_cmd("snapshow", do_snapshow,
+            " name [str ...] | Show contents of snapshot name.  Optionally "
+            "compare to expected strings, head first");
+    add_cmd("snapdrop", do_snapdrop, " name           | Drop snapshot name");
+    add_cmd("save", do_save, " file           | Save queue to file");
+    add_cmd("load", do_load,
+            " file           | Replace queue with the one saved to file");
+    add_cmd("import", do_import,
+            " file [end]     | Insert every line of file at end of queue, "
+            "where end == head or tail (default: tail)");
+    add_cmd("rm", do_rm, " file           | Remove file, such as one saved");
     add_param("length", &string_length, "Maximum length of displayed string",
               NULL);
     add_param("malloc", &fail_probability, "Malloc failure probability percent",
               NULL);
     add_param("fail", &fail_limit,
               "Number of times allow queue operations to return false", NULL);
+    add_param("layout", &layout,
+              "Element layout of new queues, 0 (pool), 1 (inline), 2 (sso), "
+              "3 (intern), 4 (arena)",
+              NULL);
+    add_param("backend", &backend,
+              "Backend of new queues, 0 (linked list), 1 (unrolled list), "
+              "2 (ring buffer), 3 (doubly linked list), 4 (compact), "
+              "5 (heap), 6 (skip list)",
+              NULL);
+    add_param("prefetch", &q_prefetch,
+              "Prefetch ahead when walking a linked list, 0 or 1", NULL);
+    add_param("async", &q_async_free,
+              "Release large freed queues in the background, 0 or 1", NULL);
+    add_param("hugepage", &huge_pages,
+              "Map new pool and arena chunks of 1 MiB or more on huge pages, 0 "
+              "or 1",
+              NULL);
 }
 
 static bool do_new(int argc, char *argv[])
@@ -124,6 +268,8 @@ static bool do_new(int argc, char *argv[])
     }
     error_check();
 
+    q_layout_register(layout);
+    q_backend_register(backend);
     if (exception_setup(true))
         q = q_new();
     exception_cancel();
@@ -156,12 +302,15 @@ static bool do_free(int argc, char *argv[])
     qcnt = 0;
     show_queue(3);
 
-    size_t bcnt = allocation_check();
-    if (bcnt > 0) {
-        report(1, "ERROR: Freed queue, but %lu blocks are still allocated",
-               bcnt);
+    /*
+     * Blocks of the other queues are still in use, so the check waits
+     * until the last of them is freed.
+     */
+    if (other_queues())
+        report(3, "Leak check deferred until the other queues and "
+                  "snapshots are freed");
+    else if (!leak_check())
         ok = false;
-    }
 
     return ok && !error_check();
 }
@@ -181,10 +330,37 @@ static void fill_rand_string(char *buf, size_t buf_size)
     buf[len] = '\0';
 }
 
+/* Most strings handed to a single batch insertion */
+#define INSERT_BATCH 64
+
+/*
+ * Fill sv with the next strings to insert, out of n still to go: either
+ * inserts, or fresh random strings when randstr_bufs is non-NULL.
+ * Return the number of strings filled.
+ */
+static int fill_insert_batch(char **sv,
+                             char randstr_bufs[][MAX_RANDSTR_LEN],
+                             char *inserts,
+                             int n)
+{
+    if (n > INSERT_BATCH)
+        n = INSERT_BATCH;
+
+    for (int i = 0; i < n; i++) {
+        if (randstr_bufs) {
+            fill_rand_string(randstr_bufs[i], MAX_RANDSTR_LEN);
+            sv[i] = randstr_bufs[i];
+        } else {
+            sv[i] = inserts;
+        }
+    }
+    return n;
+}
+
 static bool do_insert_head(int argc, char *argv[])
 {
-    char *lasts = NULL;
-    char randstr_buf[MAX_RANDSTR_LEN];
+    char randstr_bufs[INSERT_BATCH][MAX_RANDSTR_LEN];
+    char *sv[INSERT_BATCH];
     int reps = 1;
     bool ok = true, need_rand = false;
     if (argc != 2 && argc != 3) {
@@ -200,49 +376,55 @@ static bool do_insert_head(int argc, char *argv[])
         }
     }
 
-    if (!strcmp(inserts, "RAND")) {
+    if (!strcmp(inserts, "RAND"))
         need_rand = true;
-        inserts = randstr_buf;
-    }
 
     if (!q)
         report(3, "Warning: Calling insert head on null queue");
     error_check();
 
     if (exception_setup(true)) {
-        for (int r = 0; ok && r < reps; r++) {
-            if (need_rand)
-                fill_rand_string(randstr_buf, sizeof(randstr_buf));
-            bool rval = q_insert_head(q, inserts);
-            if (rval) {
-                qcnt++;
-                if (!q->head->value) {
+        for (int r = 0; ok && r < reps;) {
+            int n = fill_insert_batch(sv, need_rand ? randstr_bufs : NULL,
+                                      inserts, reps - r);
+            int m = q_insert_head_n(q, sv, n);
+            if (m) {
+                qcnt += m;
+                char *head_value = q_peek_head(q);
+                q_iter_t it;
+                q_iter_init(q, &it);
+                if (!head_value) {
                     report(1, "ERROR: Failed to save copy of string in list");
                     ok = false;
-                } else if (r == 0 && inserts == q->head->value) {
+                } else if (head_value == sv[m - 1]) {
                     report(1,
                            "ERROR: Need to allocate and copy string for new "
                            "list element");
                     ok = false;
                     break;
-                } else if (r == 1 && lasts == q->head->value) {
+                } else if (r == 0 && m > 1 &&
+                           q_iter_next(&it) == q_iter_next(&it) &&
+                           q->layout != INTERN_LAYOUT) {
+                    /* Only interned queues share equal strings on purpose */
                     report(1,
                            "ERROR: Need to allocate separate string for each "
                            "list element");
                     ok = false;
                     break;
                 }
-                lasts = q->head->value;
-            } else {
+                r += m;
+            }
+            if (m < n) {
                 fail_count++;
                 if (fail_count < fail_limit)
-                    report(2, "Insertion of %s failed", inserts);
+                    report(2, "Insertion of %s failed", sv[m]);
                 else {
                     report(1,
                            "ERROR: Insertion of %s failed (%d failures total)",
-                           inserts, fail_count);
+                           sv[m], fail_count);
                     ok = false;
                 }
+                r++;
             }
             ok = ok && !error_check();
         }
@@ -269,7 +451,8 @@ static bool do_insert_tail(int argc, char *argv[])
         return ok;
     }
 
-    char randstr_buf[MAX_RANDSTR_LEN];
+    char randstr_bufs[INSERT_BATCH][MAX_RANDSTR_LEN];
+    char *sv[INSERT_BATCH];
     int reps = 1;
     bool ok = true, need_rand = false;
     if (argc != 2 && argc != 3) {
@@ -285,33 +468,82 @@ static bool do_insert_tail(int argc, char *argv[])
         }
     }
 
-    if (!strcmp(inserts, "RAND")) {
+    if (!strcmp(inserts, "RAND"))
         need_rand = true;
-        inserts = randstr_buf;
-    }
 
     if (!q)
         report(3, "Warning: Calling insert tail on null queue");
     error_check();
 
     if (exception_setup(true)) {
-        for (int r = 0; ok && r < reps; r++) {
-            if (need_rand)
-                fill_rand_string(randstr_buf, sizeof(randstr_buf));
-            bool rval = q_insert_tail(q, inserts);
-            if (rval) {
-                qcnt++;
-                if (!q->head->value) {
+        for (int r = 0; ok && r < reps;) {
+            int n = fill_insert_batch(sv, need_rand ? randstr_bufs : NULL,
+                                      inserts, reps - r);
+            int m = q_insert_tail_n(q, sv, n);
+            if (m) {
+                qcnt += m;
+                if (!q_peek_head(q)) {
                     report(1, "ERROR: Failed to save copy of string in list");
                     ok = false;
                 }
-            } else {
+                r += m;
+            }
+            if (m < n) {
                 fail_count++;
                 if (fail_count < fail_limit)
-                    report(2, "Insertion of %s failed", inserts);
+                    report(2, "Insertion of %s failed", sv[m]);
                 else {
                     report(1,
                            "ERROR: Insertion of %s failed (%d failures total)",
+                           sv[m], fail_count);
+                    ok = false;
+                }
+                r++;
+            }
+            ok = ok && !error_check();
+        }
+    }
+    exception_cancel();
+    show_queue(3);
+    return ok;
+}
+
+static bool do_push(int argc, char *argv[])
+{
+    char randstr_buf[MAX_RANDSTR_LEN];
+    int reps = 1;
+    bool ok = true;
+    if (argc != 2 && argc != 3) {
+        report(1, "%s needs 1-2 arguments", argv[0]);
+        return false;
+    }
+
+    char *inserts = argv[1];
+    if (argc == 3 && !get_int(argv[2], &reps)) {
+        report(1, "Invalid number of insertions '%s'", argv[2]);
+        return false;
+    }
+
+    bool need_rand = !strcmp(inserts, "RAND");
+    if (need_rand)
+        inserts = randstr_buf;
+
+    if (!q)
+        report(3, "Warning: Calling push on null queue");
+    error_check();
+
+    if (exception_setup(true)) {
+        for (int r = 0; ok && r < reps; r++) {
+            if (need_rand)
+                fill_rand_string(randstr_buf, sizeof(randstr_buf));
+            if (q_push(q, inserts)) {
+                qcnt++;
+            } else {
+                fail_count++;
+                if (fail_count < fail_limit)
+                    report(2, "Push of %s failed", inserts);
+                else {
+                    report(1, "ERROR: Push of %s failed (%d failures total)",
                            inserts, fail_count);
                     ok = false;
                 }
@@ -320,11 +552,16 @@ static bool do_insert_tail(int argc, char *argv[])
         }
     }
     exception_cancel();
+
     show_queue(3);
     return ok;
 }
 
-static bool do_remove_head(int argc, char *argv[])
+/* Remove through func from end of queue, checking the copy of the string */
+static bool do_remove(int argc,
+                      char *argv[],
+                      bool (*func)(queue_t *q, char *sp, size_t bufsize),
+                      const char *end)
 {
     if (argc != 1 && argc != 2) {
         report(1, "%s needs 0-1 arguments", argv[0]);
@@ -358,14 +595,14 @@ static bool do_remove_head(int argc, char *argv[])
     removes[string_length + STRINGPAD] = '\0';
 
     if (!q)
-        report(3, "Warning: Calling remove head on null queue");
-    else if (!q->head)
-        report(3, "Warning: Calling remove head on empty queue");
+        report(3, "Warning: Calling remove %s on null queue", end);
+    else if (!q_peek_head(q))
+        report(3, "Warning: Calling remove %s on empty queue", end);
     error_check();
 
     bool rval = false;
     if (exception_setup(true))
-        rval = q_remove_head(q, removes, string_length + 1);
+        rval = func(q, removes, string_length + 1);
     exception_cancel();
 
     if (rval) {
@@ -384,8 +621,9 @@ static bool do_remove_head(int argc, char *argv[])
             i++;
         if (i != string_length + STRINGPAD) {
             report(1,
-                   "ERROR: copying of string in remove_head overflowed "
-                   "destination buffer.");
+                   "ERROR: copying of string in remove_%s overflowed "
+                   "destination buffer.",
+                   end);
             ok = false;
         } else {
             report(2, "Removed %s from queue", removes);
@@ -415,7 +653,115 @@ static bool do_remove_head(int argc, char *argv[])
     return ok && !error_check();
 }
 
+static bool do_remove_head(int argc, char *argv[])
+{
+    return do_remove(argc, argv, q_remove_head, "head");
+}
+
+static bool do_remove_tail(int argc, char *argv[])
+{
+    return do_remove(argc, argv, q_remove_tail, "tail");
+}
+
+static bool do_pop_min(int argc, char *argv[])
+{
+    return do_remove(argc, argv, q_pop_min, "min");
+}
+
 static bool do_remove_head_quiet(int argc, char *argv[])
+{
+    int reps = 1;
+    if (argc != 1 && argc != 2) {
+        report(1, "%s needs 0-1 arguments", argv[0]);
+        return false;
+    }
+    if (argc == 2 && !get_int(argv[1], &reps)) {
+        report(1, "Invalid number of removals '%s'", argv[1]);
+        return false;
+    }
+
+    bool ok = true;
+    if (!q)
+        report(3, "Warning: Calling remove head on null queue");
+    else if (!q_peek_head(q))
+        report(3, "Warning: Calling remove head on empty queue");
+    error_check();
+
+    int removed = 0;
+    if (exception_setup(true))
+        removed = reps == 1 ? q_remove_head(q, NULL, 0)
+                            : q_remove_head_n(q, NULL, reps);
+    exception_cancel();
+
+    if (removed) {
+        if (reps == 1)
+            report(2, "Removed element from queue");
+        else
+            report(2, "Removed %d elements from queue", removed);
+        qcnt -= removed;
+    }
+    if (removed < reps) {
+        fail_count++;
+        if (fail_count < fail_limit)
+            report(2, "Removal failed");
+        else {
+            report(1, "ERROR: Removal failed (%d failures total)", fail_count);
+            ok = false;
+        }
+    }
+
+    show_queue(3);
+    return ok && !error_check();
+}
+
+static bool do_remove_head_take(int argc, char *argv[])
+{
+    if (argc != 1 && argc != 2) {
+        report(1, "%s needs 0-1 arguments", argv[0]);
+        return false;
+    }
+
+    bool check = argc > 1;
+    bool ok = true;
+    if (!q)
+        report(3, "Warning: Calling remove head on null queue");
+    else if (!q_peek_head(q))
+        report(3, "Warning: Calling remove head on empty queue");
+    error_check();
+
+    const char *removed = NULL;
+    if (exception_setup(true))
+        removed = q_remove_head_take(q);
+    exception_cancel();
+
+    if (removed) {
+        report(2, "Removed %s from queue", removed);
+        if (check && strcmp(removed, argv[1])) {
+            report(1, "ERROR: Removed value %s != expected value %s", removed,
+                   argv[1]);
+            ok = false;
+        }
+        qcnt--;
+    } else {
+        fail_count++;
+        if (!check && fail_count < fail_limit) {
+            report(2, "Removal from queue failed");
+        } else {
+            report(1, "ERROR: Removal from queue failed (%d failures total)",
+                   fail_count);
+            ok = false;
+        }
+    }
+
+    if (exception_setup(true))
+        q_release(q, removed);
+    exception_cancel();
+
+    show_queue(3);
+    return ok && !error_check();
+}
+
+static bool do_remove_head_take_quiet(int argc, char *argv[])
 {
     if (argc != 1) {
         report(1, "%s takes no arguments", argv[0]);
@@ -425,16 +771,18 @@ static bool do_remove_head_quiet(int argc, char *argv[])
     bool ok = true;
     if (!q)
         report(3, "Warning: Calling remove head on null queue");
-    else if (!q->head)
+    else if (!q_peek_head(q))
         report(3, "Warning: Calling remove head on empty queue");
     error_check();
 
-    bool rval = false;
-    if (exception_setup(true))
-        rval = q_remove_head(q, NULL, 0);
+    const char *removed = NULL;
+    if (exception_setup(true)) {
+        removed = q_remove_head_take(q);
+        q_release(q, removed);
+    }
     exception_cancel();
 
-    if (rval) {
+    if (removed) {
         report(2, "Removed element from queue");
         qcnt--;
     } else {
@@ -462,7 +810,8 @@ static bool do_reverse(int argc, char *argv[])
         report(3, "Warning: Calling reverse on null queue");
     error_check();
 
-    set_noallocate_mode(true);
+    /* Snapshots of the queue are given copies of their own first */
+    set_noallocate_mode(!q_has_snapshots(q));
     if (exception_setup(true))
         q_reverse(q);
     exception_cancel();
@@ -472,6 +821,28 @@ static bool do_reverse(int argc, char *argv[])
     return !error_check();
 }
 
+static bool do_relayout(int argc, char *argv[])
+{
+    if (argc != 1) {
+        report(1, "%s takes no arguments", argv[0]);
+        return false;
+    }
+
+    bool ok = true;
+    if (!q)
+        report(3, "Warning: Calling relayout on null queue");
+    error_check();
+
+    if (exception_setup(true))
+        ok = q_relayout(q);
+    exception_cancel();
+
+    if (!ok)
+        report(1, "ERROR: Could not relayout queue");
+    show_queue(3);
+    return ok && !error_check();
+}
+
 static bool do_size(int argc, char *argv[])
 {
     if (simulation) {
@@ -535,72 +906,288 @@ static bool do_size(int argc, char *argv[])
     return ok && !error_check();
 }
 
-bool do_sort(int argc, char *argv[])
+static bool do_nth(int argc, char *argv[])
 {
-    int sort_method = MERGE_SORT;
-
-    if (argc < 1) {
-        report(1, "%s takes no arguments", argv[0]);
+    int n;
+    if (argc != 2 && argc != 3) {
+        report(1, "%s needs 1-2 arguments", argv[0]);
+        return false;
+    }
+    if (!get_int(argv[1], &n)) {
+        report(1, "Invalid index '%s'", argv[1]);
         return false;
-    } else if (argc > 2) {
-        report(1, "Too many arguments\nUsage: %s <sorting method>", argv[0]);
     }
 
     if (!q)
-        report(3, "Warning: Calling sort on null queue");
-    error_check();
-
-    int cnt = q_size(q);
-    if (cnt < 2)
-        report(3, "Warning: Calling sort on single node");
+        report(3, "Warning: Calling nth on null queue");
     error_check();
 
-    if (argc == 2)
-        sort_method = atoi(argv[1]);
-    q_sort_register_method(sort_method);
-
-    set_noallocate_mode(true);
+    char *value = NULL;
     if (exception_setup(true))
-        q_sort(q);
+        value = q_get_nth(q, n);
     exception_cancel();
-    set_noallocate_mode(false);
 
     bool ok = true;
-    if (q) {
-        for (list_ele_t *e = q->head; e && --cnt; e = e->next) {
-            /* Ensure each element in ascending order */
-            /* FIXME: add an option to specify sorting order */
-            if (strcasecmp(e->value, e->next->value) > 0) {
-                report(1, "ERROR: Not sorted in ascending order");
-                ok = false;
-                break;
-            }
-        }
+    if (!value) {
+        report(1, "ERROR: No string at index %d", n);
+        ok = false;
+    } else if (argc == 3 && strcmp(value, argv[2])) {
+        report(1, "ERROR: String at index %d is %s, expected %s", n, value,
+               argv[2]);
+        ok = false;
+    } else {
+        report(2, "String at index %d is %s", n, value);
     }
-
-    show_queue(3);
     return ok && !error_check();
 }
 
-static bool show_queue(int vlevel)
+static bool do_rank(int argc, char *argv[])
 {
+    int expected = 0;
+    if (argc != 2 && argc != 3) {
+        report(1, "%s needs 1-2 arguments", argv[0]);
+        return false;
+    }
+    if (argc == 3 && !get_int(argv[2], &expected)) {
+        report(1, "Invalid count '%s'", argv[2]);
+        return false;
+    }
+
+    if (!q)
+        report(3, "Warning: Calling rank on null queue");
+    error_check();
+
+    int rank = 0;
+    if (exception_setup(true))
+        rank = q_rank(q, argv[1]);
+    exception_cancel();
+
     bool ok = true;
-    if (verblevel < vlevel)
-        return true;
+    if (argc == 3 && rank != expected) {
+        report(1, "ERROR: Counted %d strings less than %s, expected %d", rank,
+               argv[1], expected);
+        ok = false;
+    } else {
+        report(2, "%d strings less than %s", rank, argv[1]);
+    }
+    return ok && !error_check();
+}
 
-    int cnt = 0;
-    if (!q) {
-        report(vlevel, "q = NULL");
-        return true;
+static bool do_range(int argc, char *argv[])
+{
+    if (argc < 3) {
+        report(1, "%s needs at least 2 arguments", argv[0]);
+        return false;
     }
 
-    report_noreturn(vlevel, "q = [");
-    list_ele_t *e = q->head;
+    if (!q)
+        report(3, "Warning: Calling range on null queue");
+    error_check();
+
+    int cnt = 0;
+    char *wrong = NULL;
+    int wrong_pos = 0;
     if (exception_setup(true)) {
-        while (ok && e && cnt < qcnt) {
+        q_iter_t it;
+        char *value;
+        q_iter_init_at(q, &it, q_rank(q, argv[1]));
+        report_noreturn(2, "[");
+        while ((value = q_iter_next(&it)) && strcmp(value, argv[2]) <= 0) {
             if (cnt < big_queue_size)
-                report_noreturn(vlevel, cnt == 0 ? "%s" : " %s", e->value);
-            e = e->next;
+                report_noreturn(2, cnt == 0 ? "%s" : " %s", value);
+            if (argc > 3 && !wrong && cnt < argc - 3 &&
+                strcmp(value, argv[cnt + 3])) {
+                wrong = value;
+                wrong_pos = cnt;
+            }
+            cnt++;
+        }
+        report(2, cnt <= big_queue_size ? "]" : " ... ]");
+    }
+    exception_cancel();
+
+    bool ok = true;
+    if (wrong) {
+        report(1, "ERROR: String %d from %s is %s, expected %s", wrong_pos,
+               argv[1], wrong, argv[wrong_pos + 3]);
+        ok = false;
+    } else if (argc > 3 && cnt != argc - 3) {
+        report(1, "ERROR: Found %d strings from %s to %s, expected %d", cnt,
+               argv[1], argv[2], argc - 3);
+        ok = false;
+    } else {
+        report(2, "%d strings from %s to %s", cnt, argv[1], argv[2]);
+    }
+    return ok && !error_check();
+}
+
+static bool do_index(int argc, char *argv[])
+{
+    int on = 1;
+    if (argc != 1 && argc != 2) {
+        report(1, "%s takes 0-1 arguments", argv[0]);
+        return false;
+    }
+    if (argc == 2 && !get_int(argv[1], &on)) {
+        report(1, "Invalid setting '%s'", argv[1]);
+        return false;
+    }
+
+    if (!q)
+        report(3, "Warning: Calling index on null queue");
+    error_check();
+
+    bool ok = true;
+    if (exception_setup(true)) {
+        if (on)
+            ok = q_index_enable(q);
+        else
+            q_index_disable(q);
+    }
+    exception_cancel();
+
+    if (!ok)
+        report(1, "ERROR: Could not index queue");
+    return ok && !error_check();
+}
+
+static bool do_contains(int argc, char *argv[])
+{
+    int expected = 0;
+    if (argc != 2 && argc != 3) {
+        report(1, "%s needs 1-2 arguments", argv[0]);
+        return false;
+    }
+    if (argc == 3 && (!get_int(argv[2], &expected) || expected < 0 ||
+                      expected > 1)) {
+        report(1, "Invalid answer '%s', should be 0 or 1", argv[2]);
+        return false;
+    }
+
+    if (!q)
+        report(3, "Warning: Calling contains on null queue");
+    error_check();
+
+    bool found = false;
+    if (exception_setup(true))
+        found = q_contains(q, argv[1]);
+    exception_cancel();
+
+    bool ok = true;
+    if (argc == 3 && found != expected) {
+        report(1, "ERROR: Queue %s %s, expected otherwise",
+               found ? "holds" : "does not hold", argv[1]);
+        ok = false;
+    } else {
+        report(2, "Queue %s %s", found ? "holds" : "does not hold", argv[1]);
+    }
+    return ok && !error_check();
+}
+
+static bool do_count(int argc, char *argv[])
+{
+    int expected = 0;
+    if (argc != 2 && argc != 3) {
+        report(1, "%s needs 1-2 arguments", argv[0]);
+        return false;
+    }
+    if (argc == 3 && !get_int(argv[2], &expected)) {
+        report(1, "Invalid count '%s'", argv[2]);
+        return false;
+    }
+
+    if (!q)
+        report(3, "Warning: Calling count on null queue");
+    error_check();
+
+    int cnt = 0;
+    if (exception_setup(true))
+        cnt = q_count(q, argv[1]);
+    exception_cancel();
+
+    bool ok = true;
+    if (argc == 3 && cnt != expected) {
+        report(1, "ERROR: Counted %d strings equal to %s, expected %d", cnt,
+               argv[1], expected);
+        ok = false;
+    } else {
+        report(2, "%d strings equal to %s", cnt, argv[1]);
+    }
+    return ok && !error_check();
+}
+
+bool do_sort(int argc, char *argv[])
+{
+    int sort_method = MERGE_SORT;
+
+    if (argc < 1) {
+        report(1, "%s takes no arguments", argv[0]);
+        return false;
+    } else if (argc > 2) {
+        report(1, "Too many arguments\nUsage: %s <sorting method>", argv[0]);
+    }
+
+    if (!q)
+        report(3, "Warning: Calling sort on null queue");
+    error_check();
+
+    int cnt = q_size(q);
+    if (cnt < 2)
+        report(3, "Warning: Calling sort on single node");
+    error_check();
+
+    if (argc == 2)
+        sort_method = atoi(argv[1]);
+    q_sort_register_method(sort_method);
+
+    set_noallocate_mode(!q_has_snapshots(q));
+    if (exception_setup(true))
+        q_sort(q);
+    exception_cancel();
+    set_noallocate_mode(false);
+
+    bool ok = true;
+    if (q) {
+        q_iter_t it;
+        q_iter_init(q, &it);
+        char *prev = q_iter_next(&it), *value;
+        for (; prev && --cnt && (value = q_iter_next(&it)); prev = value) {
+            /* Ensure each element in ascending order */
+            /* FIXME: add an option to specify sorting order */
+            if (strcasecmp(prev, value) > 0) {
+                report(1, "ERROR: Not sorted in ascending order");
+                ok = false;
+                break;
+            }
+        }
+    }
+
+    show_queue(3);
+    return ok && !error_check();
+}
+
+static bool show_queue(int vlevel)
+{
+    bool ok = true;
+    if (verblevel < vlevel)
+        return true;
+
+    int cnt = 0;
+    if (!q) {
+        report(vlevel, "q = NULL");
+        return true;
+    }
+
+    report_noreturn(vlevel, "q = [");
+    q_iter_t it;
+    char *value = NULL;
+    if (exception_setup(true)) {
+        q_iter_init(q, &it);
+        value = q_iter_next(&it);
+        while (ok && value && cnt < qcnt) {
+            if (cnt < big_queue_size)
+                report_noreturn(vlevel, cnt == 0 ? "%s" : " %s", value);
+            value = q_iter_next(&it);
             cnt++;
             ok = ok && !error_check();
         }
@@ -612,7 +1199,7 @@ static bool show_queue(int vlevel)
         return false;
     }
 
-    if (!e) {
+    if (!value) {
         if (cnt <= big_queue_size)
             report(vlevel, "]");
         else
@@ -638,6 +1225,337 @@ static bool do_show(int argc, char *argv[])
     return show_queue(0);
 }
 
+/*
+ * Report the heap used by all queues, per element they hold.
+ * Overhead is what is left after the bytes of the strings themselves.
+ */
+static void report_memory()
+{
+    size_t elements = 0, values = 0;
+    for (int i = 0; i < nqueues; i++) {
+        /* The queue tested is only saved to its slot when switching */
+        queue_t *qi = i == cur_queue ? q : queues[i].q;
+        if (!qi)
+            continue;
+        q_iter_t it;
+        q_iter_init(qi, &it);
+        for (char *s; (s = q_iter_next(&it));)
+            values += strlen(s) + 1;
+        elements += q_size(qi);
+    }
+
+    q_free_wait();
+    size_t bytes = allocation_bytes(), blocks = allocation_check();
+    report(1, "Heap: %lu bytes in %lu blocks, %lu bytes of strings", bytes,
+           blocks, values);
+    if (huge_regions()) {
+        report(1, "Huge pages: %lu bytes in %lu regions", huge_bytes(),
+               huge_regions());
+        bytes += huge_bytes();
+    }
+    if (elements)
+        report(1,
+               "Per element: %.1f bytes, %.1f bytes of overhead, %.2f "
+               "blocks",
+               (double) bytes / elements,
+               ((double) bytes - values) / elements,
+               (double) blocks / elements);
+}
+
+static bool do_stats(int argc, char *argv[])
+{
+    if (argc != 1) {
+        report(1, "%s takes no arguments", argv[0]);
+        return false;
+    }
+
+    if (!q) {
+        report(1, "q = NULL");
+    } else {
+        report(1, "Queue holds %d elements", q_size(q));
+        if (q_dead_bytes(q))
+            report(1, "Removed strings: %lu bytes not reclaimed yet",
+                   q_dead_bytes(q));
+        report_memory();
+    }
+
+    intern_stats_t st;
+    intern_stats(&st);
+    report(1, "Interned: %lu unique strings, %lu references", st.unique,
+           st.references);
+    report(1,
+           "Interned: %lu bytes stored for %lu bytes of values, %lu bytes "
+           "and %lu allocations saved",
+           st.stored_bytes, st.logical_bytes,
+           st.logical_bytes - st.stored_bytes, st.references - st.unique);
+    return true;
+}
+
+/*
+ * Look up counter name for the stat command.
+ * Return false if there is no such counter.
+ */
+static bool stat_value(const char *name, size_t *value)
+{
+    intern_stats_t st;
+    intern_stats(&st);
+
+    if (!strcmp(name, "unique"))
+        *value = st.unique;
+    else if (!strcmp(name, "references"))
+        *value = st.references;
+    else if (!strcmp(name, "stored"))
+        *value = st.stored_bytes;
+    else if (!strcmp(name, "logical"))
+        *value = st.logical_bytes;
+    else if (!strcmp(name, "blocks"))
+        *value = allocation_check();
+    else if (!strcmp(name, "bytes"))
+        *value = allocation_bytes();
+    else if (!strcmp(name, "dead"))
+        *value = q_dead_bytes(q);
+    else if (!strcmp(name, "regions"))
+        *value = huge_regions();
+    else
+        return false;
+    return true;
+}
+
+static bool do_stat(int argc, char *argv[])
+{
+    int expected = 0;
+    if (argc != 2 && argc != 3) {
+        report(1, "%s needs 1-2 arguments", argv[0]);
+        return false;
+    }
+    if (argc == 3 && !get_int(argv[2], &expected)) {
+        report(1, "Invalid value '%s'", argv[2]);
+        return false;
+    }
+
+    /* Queues freed in the background still hold their blocks */
+    q_free_wait();
+
+    size_t value;
+    if (!stat_value(argv[1], &value)) {
+        report(1, "Unknown counter '%s'", argv[1]);
+        return false;
+    }
+
+    if (argc == 3 && value != (size_t) expected) {
+        report(1, "ERROR: Counter %s is %lu, expected %d", argv[1], value,
+               expected);
+        return false;
+    }
+    report(2, "Counter %s is %lu", argv[1], value);
+    return true;
+}
+
+/*
+ * Whether any queue other than the one being tested exists, or any
+ * snapshot, which may hold copies of its own
+ */
+static bool other_queues()
+{
+    for (int i = 0; i < nqueues; i++) {
+        if (i != cur_queue && queues[i].q)
+            return true;
+    }
+    return nsnapshots > 0;
+}
+
+/*
+ * Once every queue and snapshot is gone, check that nothing is left.
+ * Return false after reporting what is left.
+ */
+static bool leak_check()
+{
+    /* The last queue may still be on its way out, see q_async_free */
+    q_free_wait();
+
+    size_t bcnt = allocation_check();
+    if (bcnt > 0) {
+        report(1, "ERROR: Freed queue, but %lu blocks are still allocated",
+               bcnt);
+        return false;
+    }
+    size_t hcnt = huge_regions();
+    if (hcnt > 0) {
+        report(1, "ERROR: Freed queue, but %lu huge regions are still mapped",
+               hcnt);
+        return false;
+    }
+    return true;
+}
+
+/* Find the slot of the queue called name, or return -1 */
+static int find_queue(const char *name)
+{
+    for (int i = 0; i < nqueues; i++) {
+        if (!strcmp(queues[i].name, name))
+            return i;
+    }
+    return -1;
+}
+
+/*
+ * Find the slot of the queue called name, other than the one being tested,
+ * for concat and split.  Return -1 after reporting why if there is none.
+ */
+static int find_other_queue(const char *name)
+{
+    int i = find_queue(name);
+    if (i < 0)
+        report(1, "Unknown queue '%s'", name);
+    else if (i == cur_queue)
+        report(1, "Queue '%s' is the one being tested", name);
+    else if (!queues[i].q)
+        report(3, "Warning: Queue '%s' is null", name);
+    return i == cur_queue ? -1 : i;
+}
+
+static bool do_queue(int argc, char *argv[])
+{
+    if (argc != 1 && argc != 2) {
+        report(1, "%s needs 0-1 arguments", argv[0]);
+        return false;
+    }
+
+    queues[cur_queue].q = q;
+    queues[cur_queue].qcnt = qcnt;
+
+    if (argc == 1) {
+        for (int i = 0; i < nqueues; i++) {
+            if (!queues[i].q)
+                report(1, "%c%s: NULL", i == cur_queue ? '*' : ' ',
+                       queues[i].name);
+            else
+                report(1, "%c%s: %d elements", i == cur_queue ? '*' : ' ',
+                       queues[i].name, q_size(queues[i].q));
+        }
+        return true;
+    }
+
+    int i = find_queue(argv[1]);
+    if (i < 0) {
+        if (nqueues == MAX_QUEUES) {
+            report(1, "No room for more than %d queues", MAX_QUEUES);
+            return false;
+        }
+        if (strlen(argv[1]) >= QUEUE_NAME_LEN) {
+            report(1, "Queue name '%s' is longer than %d characters", argv[1],
+                   QUEUE_NAME_LEN - 1);
+            return false;
+        }
+        i = nqueues++;
+        strcpy(queues[i].name, argv[1]);
+        queues[i].q = NULL;
+        queues[i].qcnt = 0;
+    }
+
+    cur_queue = i;
+    q = queues[i].q;
+    qcnt = queues[i].qcnt;
+    show_queue(3);
+    return true;
+}
+
+static bool do_concat(int argc, char *argv[])
+{
+    if (argc != 2) {
+        report(1, "%s needs 1 argument", argv[0]);
+        return false;
+    }
+
+    int i = find_other_queue(argv[1]);
+    if (i < 0)
+        return false;
+
+    if (!q)
+        report(3, "Warning: Calling concat on null queue");
+    error_check();
+
+    bool rval = false;
+    if (exception_setup(true))
+        rval = q_concat(q, queues[i].q);
+    exception_cancel();
+
+    bool ok = true;
+    if (rval) {
+        qcnt += queues[i].qcnt;
+        queues[i].qcnt = 0;
+        if (q_size(queues[i].q)) {
+            report(1, "ERROR: Queue '%s' not empty after concat", argv[1]);
+            ok = false;
+        }
+    } else {
+        fail_count++;
+        if (fail_count < fail_limit)
+            report(2, "Concatenation failed");
+        else {
+            report(1, "ERROR: Concatenation failed (%d failures total)",
+                   fail_count);
+            ok = false;
+        }
+    }
+
+    show_queue(3);
+    return ok && !error_check();
+}
+
+static bool do_split(int argc, char *argv[])
+{
+    int n;
+    if (argc != 3) {
+        report(1, "%s needs 2 arguments", argv[0]);
+        return false;
+    }
+    if (!get_int(argv[1], &n) || n < 0) {
+        report(1, "Invalid number of elements to keep '%s'", argv[1]);
+        return false;
+    }
+
+    int i = find_other_queue(argv[2]);
+    if (i < 0)
+        return false;
+
+    if (!q)
+        report(3, "Warning: Calling split on null queue");
+    error_check();
+
+    bool rval = false;
+    if (exception_setup(true))
+        rval = q_split(q, n, queues[i].q);
+    exception_cancel();
+
+    bool ok = true;
+    if (rval) {
+        if ((size_t) n < qcnt) {
+            queues[i].qcnt += qcnt - n;
+            qcnt = n;
+        }
+        if (q_size(q) != (int) qcnt ||
+            q_size(queues[i].q) != (int) queues[i].qcnt) {
+            report(1, "ERROR: Queue sizes %d and %d after split, expected "
+                   "%d and %d",
+                   q_size(q), q_size(queues[i].q), (int) qcnt,
+                   (int) queues[i].qcnt);
+            ok = false;
+        }
+    } else {
+        fail_count++;
+        if (fail_count < fail_limit)
+            report(2, "Split failed");
+        else {
+            report(1, "ERROR: Split failed (%d failures total)", fail_count);
+            ok = false;
+        }
+    }
+
+    show_queue(3);
+    return ok && !error_check();
+}
+
 /* Signal handlers */
 static void sigsegvhandler(int sig)
 {
@@ -666,21 +1584,274 @@ static void queue_init()
 static bool queue_quit(int argc, char *argv[])
 {
     report(3, "Freeing queue");
-    if (qcnt > big_queue_size)
-        set_cautious_mode(false);
+    queues[cur_queue].q = q;
+    queues[cur_queue].qcnt = qcnt;
+
+    /* Dropped first, so no copy is made for them as their queues go */
+    for (int i = 0; i < nsnapshots; i++) {
+        if (exception_setup(true))
+            q_snapshot_free(snapshots[i].s);
+        exception_cancel();
+    }
+    nsnapshots = 0;
+
+    for (int i = 0; i < nqueues; i++) {
+        if (queues[i].qcnt > big_queue_size)
+            set_cautious_mode(false);
+
+        if (exception_setup(true))
+            q_free(queues[i].q);
+        exception_cancel();
+        set_cautious_mode(true);
+    }
 
+    return leak_check();
+}
+
+/* Find the slot of the snapshot called name, or return -1 */
+static int find_snapshot(const char *name)
+{
+    for (int i = 0; i < nsnapshots; i++) {
+        if (!strcmp(snapshots[i].name, name))
+            return i;
+    }
+    return -1;
+}
+
+static bool do_snap(int argc, char *argv[])
+{
+    if (argc != 1 && argc != 2) {
+        report(1, "%s needs 0-1 arguments", argv[0]);
+        return false;
+    }
+
+    if (argc == 1) {
+        for (int i = 0; i < nsnapshots; i++)
+            report(1, " %s: %d elements", snapshots[i].name,
+                   q_snapshot_size(snapshots[i].s));
+        return true;
+    }
+
+    if (find_snapshot(argv[1]) >= 0) {
+        report(1, "Snapshot '%s' already exists", argv[1]);
+        return false;
+    }
+    if (nsnapshots == MAX_SNAPSHOTS) {
+        report(1, "No room for more than %d snapshots", MAX_SNAPSHOTS);
+        return false;
+    }
+    if (strlen(argv[1]) >= QUEUE_NAME_LEN) {
+        report(1, "Snapshot name '%s' is longer than %d characters", argv[1],
+               QUEUE_NAME_LEN - 1);
+        return false;
+    }
+    if (!q) {
+        report(3, "Warning: Calling snap on null queue");
+        return false;
+    }
+    error_check();
+
+    q_snapshot_t *s = NULL;
     if (exception_setup(true))
-        q_free(q);
+        s = q_snapshot(q);
     exception_cancel();
-    set_cautious_mode(true);
 
-    size_t bcnt = allocation_check();
-    if (bcnt > 0) {
-        report(1, "ERROR: Freed queue, but %lu blocks are still allocated",
-               bcnt);
+    if (!s) {
+        report(1, "ERROR: Could not take snapshot '%s'", argv[1]);
+        return false;
+    }
+
+    named_snapshot_t *ns = &snapshots[nsnapshots++];
+    strcpy(ns->name, argv[1]);
+    ns->s = s;
+    ns->size = q_size(q);
+    return !error_check();
+}
+
+static bool do_snapshow(int argc, char *argv[])
+{
+    if (argc < 2) {
+        report(1, "%s needs at least 1 argument", argv[0]);
         return false;
     }
 
+    int i = find_snapshot(argv[1]);
+    if (i < 0) {
+        report(1, "No snapshot called '%s'", argv[1]);
+        return false;
+    }
+
+    named_snapshot_t *ns = &snapshots[i];
+    int size = q_snapshot_size(ns->s);
+    if (size < 0) {
+        report(1, "%s = lost, could not allocate a copy", ns->name);
+        return true;
+    }
+
+    bool ok = true;
+    int cnt = 0;
+    char *wrong = NULL;
+    int wrong_pos = 0;
+    report_noreturn(0, "%s = [", ns->name);
+    if (exception_setup(true)) {
+        q_iter_t it;
+        q_snapshot_iter_init(ns->s, &it);
+        for (char *value; ok && (value = q_iter_next(&it)); cnt++) {
+            if (cnt < big_queue_size)
+                report_noreturn(0, cnt == 0 ? "%s" : " %s", value);
+            if (argc > 2 && !wrong && cnt < argc - 2 &&
+                strcmp(value, argv[cnt + 2])) {
+                wrong = value;
+                wrong_pos = cnt;
+            }
+            ok = cnt < ns->size;
+        }
+    }
+    exception_cancel();
+    report(0, cnt <= big_queue_size && ok ? "]" : " ... ]");
+
+    if (wrong) {
+        report(1, "ERROR: Element %d is %s, expected %s", wrong_pos, wrong,
+               argv[wrong_pos + 2]);
+        ok = false;
+    } else if (cnt != ns->size || size != ns->size) {
+        report(1, "ERROR: Snapshot shows %d elements, taken with %d", cnt,
+               ns->size);
+        ok = false;
+    } else if (argc > 2 && cnt != argc - 2) {
+        report(1, "ERROR: Snapshot shows %d elements, expected %d", cnt,
+               argc - 2);
+        ok = false;
+    }
+    return ok && !error_check();
+}
+
+static bool do_snapdrop(int argc, char *argv[])
+{
+    if (argc < 2) {
+        report(1, "%s needs at least 1 argument", argv[0]);
+        return false;
+    }
+
+    int i = find_snapshot(argv[1]);
+    if (i < 0) {
+        report(1, "No snapshot called '%s'", argv[1]);
+        return false;
+    }
+
+    if (exception_setup(true))
+        q_snapshot_free(snapshots[i].s);
+    exception_cancel();
+
+    snapshots[i] = snapshots[--nsnapshots];
+
+    /* Run the check do_free() deferred while the snapshot was around */
+    bool ok = true;
+    if (!q && !other_queues())
+        ok = leak_check();
+    return ok && !error_check();
+}
+
+static bool do_save(int argc, char *argv[])
+{
+    if (argc != 2) {
+        report(1, "%s needs 1 argument", argv[0]);
+        return false;
+    }
+
+    bool ok = true;
+    if (!q)
+        report(3, "Warning: Calling save on null queue");
+    error_check();
+
+    if (exception_setup(true))
+        ok = q_save(q, argv[1]);
+    exception_cancel();
+
+    if (!ok)
+        report(1, "ERROR: Could not save queue to '%s'", argv[1]);
+    return ok && !error_check();
+}
+
+static bool do_load(int argc, char *argv[])
+{
+    if (argc != 2) {
+        report(1, "%s needs 1 argument", argv[0]);
+        return false;
+    }
+
+    bool ok = true;
+    if (q) {
+        report(3, "Freeing old queue");
+        char *free_argv[] = {"free"};
+        ok = do_free(1, free_argv);
+    }
+    error_check();
+
+    q_layout_register(layout);
+    q_backend_register(backend);
+    if (exception_setup(true))
+        q = q_load(argv[1]);
+    exception_cancel();
+
+    if (!q) {
+        report(1, "ERROR: Could not load queue from '%s'", argv[1]);
+        ok = false;
+    }
+    qcnt = q_size(q);
+    show_queue(3);
+
+    return ok && !error_check();
+}
+
+static bool do_import(int argc, char *argv[])
+{
+    if (argc != 2 && argc != 3) {
+        report(1, "%s takes 1-2 arguments", argv[0]);
+        return false;
+    }
+
+    bool head = false;
+    if (argc == 3) {
+        if (strcmp(argv[2], "head") && strcmp(argv[2], "tail")) {
+            report(1, "Invalid end '%s', should be head or tail", argv[2]);
+            return false;
+        }
+        head = !strcmp(argv[2], "head");
+    }
+
+    if (!q)
+        report(3, "Warning: Calling import on null queue");
+    error_check();
+
+    int cnt = -1;
+    if (exception_setup(true))
+        cnt = q_import(q, argv[1], head);
+    exception_cancel();
+
+    qcnt = q_size(q);
+    if (cnt < 0) {
+        report(1, "ERROR: Could not import '%s'", argv[1]);
+        show_queue(3);
+        return false;
+    }
+    report(2, "Imported %d strings", cnt);
+    show_queue(3);
+    return !error_check();
+}
+
+static bool do_rm(int argc, char *argv[])
+{
+    if (argc != 2) {
+        report(1, "%s needs 1 argument", argv[0]);
+        return false;
+    }
+
+    if (unlink(argv[1]) != 0) {
+        report(1, "ERROR: Could not remove '%s': %s", argv[1],
+               strerror(errno));
+        return false;
+    }
     return true;
 }
 
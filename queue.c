@@ -1,8 +1,16 @@
+#include <pthread.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "backend.h"
 #include "harness.h"
+#include "hashindex.h"
+#include "intern.h"
+#include "merge_runs.h"
 #include "queue.h"
 
 /* GUARD of NULL pointer */
@@ -14,175 +22,1356 @@
 
 /* Actual function that sort the elements in queue. */
 static void merge_sort(queue_t *q);
-static list_ele_t *do_merge_sort(list_ele_t *);
-static list_ele_t *do_merge(list_ele_t *, list_ele_t *);
+static run_t do_merge(void *priv, run_t a, run_t b);
 
 static void selection_sort(queue_t *q);
 static void bubble_sort(queue_t *q);
+static void pending_merge_sort(queue_t *q);
+
+static void sort_dispatch(queue_t *q);
+
+static void snap_insert_head(queue_t *q, int n);
+static void snap_detach_all(queue_t *q);
+static void ele_drop(queue_t *q, list_ele_t *e);
+
+/* Every sort goes through the dispatcher, which picks the actual method */
+void (*q_sort)(queue_t *q) = sort_dispatch;
+
+/* Sorting method of the linked list, registered by q_sort_register_method */
+static void (*list_sort_method)(queue_t *q) = merge_sort;
 
 /* Array of function pointer which points to the actual sort function */
 void (*sort_func[SORT_METHOD_NUM])(queue_t *q) = {
     merge_sort,
     selection_sort,
     bubble_sort,
+    pending_merge_sort,
+};
+
+/*
+ * Bytes of string storage inside each element of SSO_LAYOUT, including the
+ * null terminator.  Large enough for the random strings generated by qtest.
+ */
+#define SSO_CAPACITY 16
+
+/* Element of the list at position pos, see q_relayout() */
+typedef struct {
+    list_ele_t *e;
+    int pos;
+} relayout_slot_t;
+
+/* Bytes taken from the arena by an element holding a string of len bytes */
+#define ARENA_ELE_SIZE(len) (sizeof(list_ele_t) + (len) + 1)
+
+/* Layout given to queues created by q_new() */
+static int new_layout = POOL_LAYOUT;
+
+/* Backends selectable by q_backend_register(), NULL for the linked list */
+static const backend_t *backends[BACKEND_NUM] = {
+    NULL,
+    &unrolled_backend,
+    &ring_backend,
+    &dlist_backend,
+    &compact_backend,
+    &heap_backend,
+    &skiplist_backend,
 };
 
+/* Backend given to queues created by q_new() */
+static int new_backend = LIST_BACKEND;
+
+/*
+ * Whether walks over the linked list issue prefetch hints.  Off by default,
+ * as they only pay off on lists scattered over memory.
+ */
+int q_prefetch = 0;
+
+/*
+ * Hint the cache about the element after e, as e is reached one element
+ * ahead of a walk.  Reading the link of e waits for e itself, so this only
+ * overlaps the fetch of the next element with the work left on the current
+ * one; it does not run further ahead.
+ */
+static inline void ele_prefetch_next(const list_ele_t *e)
+{
+    if (!q_prefetch || !e)
+        return;
+    __builtin_prefetch(e->next);
+}
+
+/* Same, and also about the string of e, for walks that read it */
+static inline void ele_prefetch(const list_ele_t *e)
+{
+    if (!q_prefetch || !e)
+        return;
+    __builtin_prefetch(e->next);
+    __builtin_prefetch(e->value);
+}
+
+/*
+ * Allocate a null-terminated copy of the len bytes of s.
+ * Return NULL if could not allocate space.
+ */
+char *backend_copy_string(const char *s, size_t len)
+{
+    char *value = malloc(len + 1);
+    NULL_PTR_GUARD(value);
+
+    memcpy(value, s, len);
+    value[len] = '\0';
+    return value;
+}
+
+/*
+ * Allocate an element holding a copy of the len bytes of s, following the
+ * layout of the queue.  The next field is left for the caller to fill.
+ * Return NULL if could not allocate space.
+ */
+static list_ele_t *ele_new(queue_t *q, const char *s, size_t len)
+{
+    list_ele_t *e;
+
+    if (q->layout == INLINE_LAYOUT || q->layout == ARENA_LAYOUT) {
+        e = q->layout == ARENA_LAYOUT
+                ? arena_alloc(&q->mem->arena, ARENA_ELE_SIZE(len))
+                : malloc(sizeof(list_ele_t) + len + 1);
+        NULL_PTR_GUARD(e);
+        e->value = e->inline_value;
+    } else {
+        e = pool_alloc(&q->mem->pool);
+        NULL_PTR_GUARD(e);
+        /* Short strings stay in the element, longer ones spill to the heap */
+        if (q->layout == SSO_LAYOUT && len < SSO_CAPACITY) {
+            e->value = e->inline_value;
+        } else {
+            /* Interned strings are shared, and already hold their bytes */
+            e->value = q->layout == INTERN_LAYOUT ? intern_get(s, len)
+                                                  : malloc(len + 1);
+            if (!e->value) {
+                pool_free(&q->mem->pool, e);
+                return NULL;
+            }
+        }
+    }
+
+    if (q->layout != INTERN_LAYOUT) {
+        memcpy(e->value, s, len);
+        e->value[len] = '\0';
+    }
+    e->len = len;
+    return e;
+}
+
+/*
+ * Compare the strings of two elements like strcmp(), using the cached
+ * lengths so neither string is scanned for its terminator.
+ */
+static inline int ele_cmp(const list_ele_t *a, const list_ele_t *b)
+{
+    size_t n = a->len < b->len ? a->len : b->len;
+    int cmp = memcmp(a->value, b->value, n);
+    if (cmp)
+        return cmp;
+    return (a->len > b->len) - (a->len < b->len);
+}
+
+/* Release an element together with its string */
+static void ele_free(queue_t *q, list_ele_t *e)
+{
+    if (q->layout == INLINE_LAYOUT) {
+        free(e);
+    } else if (q->layout == ARENA_LAYOUT) {
+        arena_free(&q->mem->arena, e, ARENA_ELE_SIZE(e->len));
+    } else {
+        if (q->layout == INTERN_LAYOUT)
+            intern_put(e->value);
+        else if (e->value != e->inline_value)
+            free(e->value);
+        pool_free(&q->mem->pool, e);
+    }
+}
+
+/* Element holding s, for strings kept inside their element */
+#define VALUE_ELE(s) \
+    ((list_ele_t *) ((s) - offsetof(list_ele_t, inline_value)))
+
+/* Unlink the element at head of the list, which must not be empty */
+static list_ele_t *list_unlink_head(queue_t *q)
+{
+    list_ele_t *old_h = q->head;
+
+    q->head = old_h->next;
+
+    /* Update q->tail if q->size == 1 */
+    /* TODO: Apply Good-Taste to the update of q->tail */
+    if (q->size == 1)
+        q->tail = NULL;
+
+    q->size--;
+    return old_h;
+}
+
+/* Drop the index of a queue whose strings can no longer be told */
+static void index_drop(queue_t *q)
+{
+    hindex_free(q->index);
+    q->index = NULL;
+}
+
+/*
+ * Count the len bytes of s in the index of queue, if any.  An index that
+ * cannot grow is dropped, since it would miss the string.
+ */
+static void index_add(queue_t *q, const char *s, size_t len)
+{
+    if (q->index && !hindex_add(q->index, s, len))
+        index_drop(q);
+}
+
+/* Count the first n strings of sv in the index of queue, if any */
+static void index_add_n(queue_t *q, char **sv, int n)
+{
+    for (int i = 0; q->index && i < n; i++)
+        index_add(q, sv[i], strlen(sv[i]));
+}
+
+/* Count s once less in the index of queue, if any */
+static void index_remove(queue_t *q, const char *s)
+{
+    if (q->index)
+        hindex_remove(q->index, s, strlen(s));
+}
+
+/*
+ * Move the counts of the strings of from, from its n-th one on, to the
+ * index of to.  Either queue may be indexed or not.
+ */
+static void index_move(queue_t *from, int n, queue_t *to)
+{
+    if (!from->index && !to->index)
+        return;
+
+    q_iter_t it;
+    q_iter_init_at(from, &it, n);
+    for (char *value; (value = q_iter_next(&it));) {
+        index_remove(from, value);
+        index_add(to, value, strlen(value));
+    }
+}
+
+/*
+ * Hand the string of an unlinked element over, see q_remove_head_take().
+ * A string kept inside its element takes the element along.
+ */
+static char *ele_take(queue_t *q, list_ele_t *e)
+{
+    char *value = e->value;
+
+    if (value != e->inline_value)
+        pool_free(&q->mem->pool, e);
+    return value;
+}
+
+/*
+ * Create empty queue with the given layout and backend.
+ * Return NULL if could not allocate space.
+ */
+static queue_t *queue_new(int layout, const backend_t *backend)
+{
+    queue_t *q = malloc(sizeof(queue_t));
+    NULL_PTR_GUARD(q);
+
+    q->head = NULL;
+    q->tail = NULL;
+    q->size = 0;
+    q->layout = layout;
+    q->backend = backend;
+    q->store = NULL;
+    q->snaps = NULL;
+    q->index = NULL;
+
+    /* Allocators that are not set up stay zeroed, and empty */
+    q->mem = malloc(sizeof(mem_t));
+    if (!q->mem) {
+        free(q);
+        return NULL;
+    }
+    memset(q->mem, 0, sizeof(mem_t));
+    q->mem->users = q;
+    q->mem_next = NULL;
+
+    bool ok = true;
+    if (q->backend) {
+        ok = q->backend->init(q);
+    } else if (q->layout == ARENA_LAYOUT) {
+        ok = arena_init(&q->mem->arena);
+    } else if (q->layout != INLINE_LAYOUT) {
+        size_t ele_size = sizeof(list_ele_t);
+        if (q->layout == SSO_LAYOUT)
+            ele_size += SSO_CAPACITY;
+        ok = pool_init(&q->mem->pool, ele_size);
+    }
+
+    if (!ok) {
+        free(q->mem);
+        free(q);
+        return NULL;
+    }
+    return q;
+}
+
+/*
+ * Create empty queue.
+ * Return NULL if could not allocate space.
+ */
+queue_t *q_new()
+{
+    return queue_new(new_layout, backends[new_backend]);
+}
+
+/* Stop drawing from q->mem, which goes away once it has no user left */
+static void mem_leave(queue_t *q)
+{
+    mem_t *mem = q->mem;
+    queue_t **indirect = &mem->users;
+
+    while (*indirect != q)
+        indirect = &(*indirect)->mem_next;
+    *indirect = q->mem_next;
+
+    if (!mem->users) {
+        pool_destroy(&mem->pool);
+        arena_destroy(&mem->arena);
+        free(mem);
+    }
+}
+
+/*
+ * Have a and b draw from the same allocators, so elements can move from
+ * one queue to the other.  The chunks of b and of every queue sharing them
+ * are merged into those of a.
+ */
+static void mem_join(queue_t *a, queue_t *b)
+{
+    mem_t *to = a->mem, *from = b->mem;
+    if (to == from)
+        return;
+
+    pool_merge(&to->pool, &from->pool);
+    arena_merge(&to->arena, &from->arena);
+
+    queue_t *last = NULL;
+    for (queue_t *u = from->users; u; u = u->mem_next) {
+        u->mem = to;
+        last = u;
+    }
+    last->mem_next = to->users;
+    to->users = from->users;
+    free(from);
+}
+
+/* Release the elements of queue, then queue itself */
+static void queue_release(queue_t *q)
+{
+    if (q->backend) {
+        q->backend->release(q);
+    } else if (q->layout == ARENA_LAYOUT && q->mem->users == q &&
+               !q->mem_next) {
+        /* Arena elements own nothing, they all go away with its chunks */
+    } else {
+        list_ele_t *tmp;
+
+        for (tmp = q->head; tmp;) {
+            /* Store the next element */
+            q->head = tmp->next;
+            ele_prefetch(q->head);
+            ele_free(q, tmp);
+            tmp = q->head;
+        }
+    }
+
+    /* Chunks only go away with the last queue drawing from them */
+    mem_leave(q);
+    index_drop(q);
+    free(q);
+}
+
+/* Whether q_free() hands large queues over to the reclaimer thread */
+int q_async_free = 0;
+
+/* Below this many elements, a queue is released sooner than handed over */
+#define ASYNC_FREE_MIN 1024
+
+/*
+ * Queues handed over to the reclaimer, linked through mem_next: each of
+ * them is the only user of its allocators, so the field is free.
+ */
+static queue_t *reclaim_pending = NULL;
+static bool reclaim_busy = false;   /* Whether a batch is being released */
+static bool reclaim_started = false;
+static pthread_mutex_t reclaim_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t reclaim_wake = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t reclaim_idle = PTHREAD_COND_INITIALIZER;
+
+/*
+ * Whether queue can be released by another thread.  Allocators shared with
+ * other queues, and the table of interned strings, are only ever touched
+ * by the thread calling the queue functions.
+ */
+static bool reclaimable(const queue_t *q)
+{
+    if (q->size < ASYNC_FREE_MIN)
+        return false;
+    if (!q->backend && q->layout == INTERN_LAYOUT)
+        return false;
+    return q->mem->users == q && !q->mem_next;
+}
+
+/*
+ * Body of the reclaimer thread.  Every queue handed over since the last
+ * batch is taken at once, and released without holding the lock.
+ */
+static void *reclaimer(void *arg)
+{
+    test_reclaim_thread();
+
+    pthread_mutex_lock(&reclaim_lock);
+    for (;;) {
+        while (!reclaim_pending)
+            pthread_cond_wait(&reclaim_wake, &reclaim_lock);
+        queue_t *batch = reclaim_pending;
+        reclaim_pending = NULL;
+        reclaim_busy = true;
+        pthread_mutex_unlock(&reclaim_lock);
+
+        while (batch) {
+            queue_t *next = batch->mem_next;
+            batch->mem_next = NULL;
+            queue_release(batch);
+            batch = next;
+        }
+
+        pthread_mutex_lock(&reclaim_lock);
+        reclaim_busy = false;
+        pthread_cond_broadcast(&reclaim_idle);
+    }
+    return NULL;
+}
+
+/*
+ * Start the reclaimer, with every signal blocked so the time limits of the
+ * harness keep hitting the thread they were set for.
+ * Return false if the thread could not be created.
+ */
+static bool reclaimer_start()
+{
+    sigset_t all, old;
+    pthread_t tid;
+
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &old);
+    bool ok = !pthread_create(&tid, NULL, reclaimer, NULL);
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+    if (ok)
+        pthread_detach(tid);
+    return ok;
+}
+
+/* Hand queue over to the reclaimer, return false if it could not start */
+static bool reclaim_handoff(queue_t *q)
+{
+    pthread_mutex_lock(&reclaim_lock);
+    if (!reclaim_started)
+        reclaim_started = reclaimer_start();
+    if (reclaim_started) {
+        q->mem_next = reclaim_pending;
+        reclaim_pending = q;
+        pthread_cond_signal(&reclaim_wake);
+    }
+    pthread_mutex_unlock(&reclaim_lock);
+    return reclaim_started;
+}
+
+/* Free all storage used by queue */
+void q_free(queue_t *q)
+{
+    if (!q)
+        return;
+
+    snap_detach_all(q);
+    if (q_async_free && reclaimable(q) && reclaim_handoff(q))
+        return;
+    queue_release(q);
+}
+
+/* Wait until every queue handed over by q_free() has been released */
+void q_free_wait()
+{
+    pthread_mutex_lock(&reclaim_lock);
+    while (reclaim_pending || reclaim_busy)
+        pthread_cond_wait(&reclaim_idle, &reclaim_lock);
+    pthread_mutex_unlock(&reclaim_lock);
+}
+
+/*
+ * Attempt to insert element at head of queue.
+ * Return true if successful.
+ * Return false if q is NULL or could not allocate space.
+ * Argument s points to the string to be stored.
+ * The function must explicitly allocate space and copy the string into it.
+ */
+bool q_insert_head(queue_t *q, char *s)
+{
+    /* Guard of NULL pointer */
+    NULL_PTR_GUARD(q);
+    size_t len = strlen(s);
+    NULL_PTR_GUARD(len);
+
+    if (q->backend) {
+        if (!q->backend->insert_head(q, s, len))
+            return false;
+        index_add(q, s, len);
+        return true;
+    }
+
+    list_ele_t *newh = ele_new(q, s, len);
+    NULL_PTR_GUARD(newh);
+
+    newh->next = q->head;
+    q->head = newh;
+
+    if (!q->tail)
+        q->tail = newh;
+
+    q->size++;
+    snap_insert_head(q, 1);
+    index_add(q, s, len);
+
+    return true;
+}
+
+/*
+ * Attempt to insert element at tail of queue.
+ * Return true if successful.
+ * Return false if q is NULL or could not allocate space.
+ * Argument s points to the string to be stored.
+ * The function must explicitly allocate space and copy the string into it.
+ */
+bool q_insert_tail(queue_t *q, char *s)
+{
+    NULL_PTR_GUARD(q);
+    size_t len = strlen(s);
+
+    if (q->backend) {
+        if (!q->backend->insert_tail(q, s, len))
+            return false;
+        index_add(q, s, len);
+        return true;
+    }
+
+    list_ele_t *newt = ele_new(q, s, len);
+    NULL_PTR_GUARD(newt);
+    newt->next = NULL;
+
+    if (!q->tail) {  // empty queue
+        q->tail = newt;
+        q->head = newt;
+    } else {
+        q->tail->next = newt;
+        q->tail = q->tail->next;
+    }
+
+    q->size++;
+    index_add(q, s, len);
+
+    return true;
+}
+
+/*
+ * Attempt to insert the n strings of sv, one after the other, at head of
+ * queue.  The elements are chained apart and spliced in at once.
+ * Return the number of strings inserted, less than n only if q is NULL,
+ * could not allocate space, or the next string is empty.
+ */
+int q_insert_head_n(queue_t *q, char **sv, int n)
+{
+    NULL_PTR_GUARD(q);
+    int i;
+
+    /* An empty string stops the batch, as q_insert_head() rejects it */
+    if (q->backend) {
+        for (i = 0; i < n; i++)
+            if (!*sv[i] || !q->backend->insert_head(q, sv[i], strlen(sv[i])))
+                break;
+        index_add_n(q, sv, i);
+        return i;
+    }
+
+    /* The chain runs from sv[i - 1], its head, back to sv[0], its tail */
+    list_ele_t *first = NULL, *last = NULL;
+    for (i = 0; i < n && *sv[i]; i++) {
+        list_ele_t *e = ele_new(q, sv[i], strlen(sv[i]));
+        if (!e)
+            break;
+        e->next = first;
+        first = e;
+        if (!last)
+            last = e;
+    }
+    if (!i)
+        return 0;
+
+    last->next = q->head;
+    q->head = first;
+    if (!q->tail)
+        q->tail = last;
+    q->size += i;
+    snap_insert_head(q, i);
+    index_add_n(q, sv, i);
+
+    return i;
+}
+
+/*
+ * Attempt to insert the n strings of sv, one after the other, at tail of
+ * queue.  The elements are chained apart and spliced in at once.
+ * Return the number of strings inserted, less than n only if q is NULL or
+ * could not allocate space.
+ */
+int q_insert_tail_n(queue_t *q, char **sv, int n)
+{
+    NULL_PTR_GUARD(q);
+    int i;
+
+    if (q->backend) {
+        for (i = 0; i < n; i++)
+            if (!q->backend->insert_tail(q, sv[i], strlen(sv[i])))
+                break;
+        index_add_n(q, sv, i);
+        return i;
+    }
+
+    list_ele_t *first = NULL, *last = NULL;
+    for (i = 0; i < n; i++) {
+        list_ele_t *e = ele_new(q, sv[i], strlen(sv[i]));
+        if (!e)
+            break;
+        e->next = NULL;
+        if (last)
+            last->next = e;
+        else
+            first = e;
+        last = e;
+    }
+    if (!i)
+        return 0;
+
+    if (q->tail)
+        q->tail->next = first;
+    else
+        q->head = first;
+    q->tail = last;
+    q->size += i;
+    index_add_n(q, sv, i);
+
+    return i;
+}
+
+/*
+ * Remove an element through the take hook of the backend, copying its
+ * string to sp as q_remove_head() does.
+ */
+static bool backend_remove(queue_t *q,
+                           char *(*take)(queue_t *q),
+                           char *sp,
+                           size_t bufsize)
+{
+    char *value = take(q);
+    if (!value)
+        return false;
+    index_remove(q, value);
+
+    if (sp && bufsize) {
+        size_t ncopy = strnlen(value, bufsize - 1);
+        memcpy(sp, value, ncopy);
+        sp[ncopy] = '\0';
+    }
+    free(value);
+    return true;
+}
+
+/*
+ * Attempt to remove element from head of queue.
+ * Return true if successful.
+ * Return false if queue is NULL or empty.
+ * If sp is non-NULL and an element is removed, copy the removed string to *sp
+ * (up to a maximum of bufsize-1 characters, plus a null terminator.)
+ * The space used by the list element and the string should be freed.
+ */
+bool q_remove_head(queue_t *q, char *sp, size_t bufsize)
+{
+    list_ele_t *old_h;
+
+    if (!q || !q->size)
+        return false;
+
+    if (q->backend)
+        return backend_remove(q, q->backend->take_head, sp, bufsize);
+
+    old_h = list_unlink_head(q);
+    index_remove(q, old_h->value);
+    if (sp && bufsize) {
+        /* Only the bytes that fit are touched, thanks to the cached length */
+        size_t ncopy = old_h->len < bufsize - 1 ? old_h->len : bufsize - 1;
+        memcpy(sp, old_h->value, ncopy);
+        sp[ncopy] = '\0';
+    }
+
+    ele_drop(q, old_h);
+
+    return true;
+}
+
+/*
+ * Attempt to remove element from tail of queue.
+ * Same contract as q_remove_head().
+ */
+bool q_remove_tail(queue_t *q, char *sp, size_t bufsize)
+{
+    if (!q || !q->size)
+        return false;
+
+    if (q->backend)
+        return backend_remove(q, q->backend->take_tail, sp, bufsize);
+
+    /* Snapshots would lose the link to the tail */
+    snap_detach_all(q);
+    list_ele_t *old_t = q->tail;
+    if (sp && bufsize) {
+        size_t ncopy = old_t->len < bufsize - 1 ? old_t->len : bufsize - 1;
+        memcpy(sp, old_t->value, ncopy);
+        sp[ncopy] = '\0';
+    }
+
+    if (q->size == 1) {
+        q->head = NULL;
+        q->tail = NULL;
+    } else {
+        /* Without a link back, the new tail has to be found from the head */
+        list_ele_t *prev = q->head;
+        while (prev->next != old_t)
+            prev = prev->next;
+        prev->next = NULL;
+        q->tail = prev;
+    }
+
+    index_remove(q, old_t->value);
+    ele_free(q, old_t);
+    q->size--;
+    return true;
+}
+
+/*
+ * Remove the element at head of queue and hand its string to the caller.
+ * Return NULL if q is NULL or empty.
+ */
+const char *q_remove_head_take(queue_t *q)
+{
+    if (!q || !q->size)
+        return NULL;
+    char *value;
+    if (q->backend) {
+        value = q->backend->take_head(q);
+    } else {
+        /* The string is handed over, so snapshots cannot keep showing it */
+        snap_detach_all(q);
+        value = ele_take(q, list_unlink_head(q));
+    }
+    if (value)
+        index_remove(q, value);
+    return value;
+}
+
+/*
+ * Remove up to n elements from head of queue at once.
+ * If sv is non-NULL, their strings are handed over in sv, in queue order,
+ * as by q_remove_head_take(); otherwise they are freed.
+ * Return the number of elements removed, 0 if q is NULL.
+ */
+int q_remove_head_n(queue_t *q, const char **sv, int n)
+{
+    NULL_PTR_GUARD(q);
+    int m = n < q->size ? n : q->size;
+
+    if (m <= 0)
+        return 0;
+
+    if (q->backend) {
+        for (int i = 0; i < m; i++) {
+            char *value = q->backend->take_head(q);
+            if (!value)
+                return i;
+            index_remove(q, value);
+            if (sv)
+                sv[i] = value;
+            else
+                free(value);
+        }
+        return m;
+    }
+
+    /*
+     * Unlink each element before disposing of it, so a time limit expiring
+     * midway leaves the queue holding the elements not yet removed.
+     */
+    if (sv)
+        snap_detach_all(q);
+    for (int i = 0; i < m; i++) {
+        list_ele_t *e = list_unlink_head(q);
+        index_remove(q, e->value);
+        if (sv)
+            sv[i] = ele_take(q, e);
+        else
+            ele_drop(q, e);
+    }
+
+    return m;
+}
+
+/*
+ * Release a string returned by q_remove_head_take(), together with
+ * whatever storage of q came along with it.  No effect if s is NULL.
+ */
+void q_release(queue_t *q, const char *s)
+{
+    /* The string goes back to the storage it was taken from */
+    char *value = (char *) s;
+
+    if (!value)
+        return;
+    if (q->backend) {
+        free(value);
+        return;
+    }
+
+    switch (q->layout) {
+    case INLINE_LAYOUT:
+        free(VALUE_ELE(value));
+        break;
+    case ARENA_LAYOUT:
+        arena_free(&q->mem->arena, VALUE_ELE(value),
+                   ARENA_ELE_SIZE(VALUE_ELE(value)->len));
+        break;
+    case SSO_LAYOUT:
+        /* A string kept inside its element lies in a chunk of the pool */
+        if (pool_owns(&q->mem->pool, value))
+            pool_free(&q->mem->pool, VALUE_ELE(value));
+        else
+            free(value);
+        break;
+    case INTERN_LAYOUT:
+        intern_put(value);
+        break;
+    default:
+        free(value);
+        break;
+    }
+}
+
+/*
+ * Return the string stored at the head of queue, without removing it.
+ * Return NULL if q is NULL or empty.
+ */
+char *q_peek_head(queue_t *q)
+{
+    if (!q || !q->size)
+        return NULL;
+    if (q->backend)
+        return q->backend->peek_head(q);
+    return q->head->value;
+}
+
+/*
+ * Attempt to insert element into a heap queue.
+ * Return false if q is NULL, is not a heap, or could not allocate space.
+ */
+bool q_push(queue_t *q, char *s)
+{
+    if (!q || q->backend != &heap_backend)
+        return false;
+
+    size_t len = strlen(s);
+    if (!heap_backend.insert_tail(q, s, len))
+        return false;
+    index_add(q, s, len);
+    return true;
+}
+
+/*
+ * Attempt to remove the smallest string from a heap queue.
+ * Return false if q is NULL, is not a heap, or is empty.
+ */
+bool q_pop_min(queue_t *q, char *sp, size_t bufsize)
+{
+    if (!q || q->backend != &heap_backend || !q->size)
+        return false;
+    return backend_remove(q, heap_backend.take_head, sp, bufsize);
+}
 
 /*
- * Create empty queue.
- * Return NULL if could not allocate space.
+ * Return number of elements in queue.
+ * Return 0 if q is NULL or empty
  */
-queue_t *q_new()
+int q_size(queue_t *q)
 {
-    queue_t *q = malloc(sizeof(queue_t));
     NULL_PTR_GUARD(q);
-
-    q->head = NULL;
-    q->tail = NULL;
-    q->size = 0;
-
-    return q;
+    return q->size;
 }
 
-/* Free all storage used by queue */
-void q_free(queue_t *q)
+/*
+ * Start a walk over the strings of queue, from head to tail.
+ * A NULL queue is walked as an empty one.
+ */
+void q_iter_init(queue_t *q, q_iter_t *it)
 {
+    it->q = q;
+    it->node = NULL;
+    it->index = 0;
+
     if (!q)
         return;
+    if (q->backend) {
+        q->backend->iter_init(it);
+    } else {
+        it->node = q->head;
+        it->index = q->size;
+    }
+}
 
-    list_ele_t *tmp;
+/* Return the next string of the walk, or NULL once past the tail */
+char *q_iter_next(q_iter_t *it)
+{
+    if (it->q && it->q->backend)
+        return it->q->backend->iter_next(it);
+
+    /* Counted down, as a snapshot ends before the list it shares does */
+    list_ele_t *e = it->node;
+    if (!e || !it->index)
+        return NULL;
+    it->node = --it->index ? e->next : NULL;
+    ele_prefetch(it->node);
+    return e->value;
+}
+
+/* Start a walk at the n-th string, see q_iter_init_at() */
+void q_iter_init_at(queue_t *q, q_iter_t *it, int n)
+{
+    /* Out of range, the walk is that of a NULL queue */
+    if (!q || n < 0 || n >= q->size) {
+        q_iter_init(NULL, it);
+        return;
+    }
 
-    for (tmp = q->head; tmp;) {
-        /* Store the next element */
-        q->head = tmp->next;
-        free(tmp->value);
-        free(tmp);
-        tmp = q->head;
+    q_iter_init(q, it);
+    if (q->backend && q->backend->iter_seek) {
+        q->backend->iter_seek(it, n);
+        return;
     }
+    while (n--)
+        q_iter_next(it);
+}
 
-    free(q);
+/*
+ * Return the n-th string of queue, 0 being the head.
+ * Return NULL if q is NULL or n is out of range.
+ */
+char *q_get_nth(queue_t *q, int n)
+{
+    if (!q || n < 0 || n >= q->size)
+        return NULL;
+    if (q->backend && q->backend->get_nth)
+        return q->backend->get_nth(q, n);
+
+    q_iter_t it;
+    q_iter_init_at(q, &it, n);
+    return q_iter_next(&it);
+}
+
+/* Return the number of strings of queue less than s, 0 if q is NULL */
+int q_rank(queue_t *q, const char *s)
+{
+    if (!q)
+        return 0;
+    if (q->backend && q->backend->rank)
+        return q->backend->rank(q, s);
+
+    int rank = 0;
+    q_iter_t it;
+    q_iter_init(q, &it);
+    for (char *value; (value = q_iter_next(&it));)
+        rank += strcmp(value, s) < 0;
+    return rank;
 }
 
 /*
- * Attempt to insert element at head of queue.
- * Return true if successful.
+ * Index the strings of queue by hash.
  * Return false if q is NULL or could not allocate space.
- * Argument s points to the string to be stored.
- * The function must explicitly allocate space and copy the string into it.
  */
-bool q_insert_head(queue_t *q, char *s)
+bool q_index_enable(queue_t *q)
 {
-    /* Guard of NULL pointer */
-    size_t len = strlen(s);
-    NULL_PTR_GUARD(q);
-    NULL_PTR_GUARD(len);
+    if (!q)
+        return false;
+    if (q->index)
+        return true;
 
-    list_ele_t *newh;
-    newh = malloc(sizeof(list_ele_t));
-    NULL_PTR_GUARD(newh);
+    q->index = hindex_new();
+    q_iter_t it;
+    q_iter_init(q, &it);
+    for (char *value; q->index && (value = q_iter_next(&it));)
+        index_add(q, value, strlen(value));
+    return q->index;
+}
+
+/* Drop the index of queue, if any */
+void q_index_disable(queue_t *q)
+{
+    if (q)
+        index_drop(q);
+}
+
+/* Return the number of strings of queue equal to s, 0 if q is NULL */
+int q_count(queue_t *q, const char *s)
+{
+    if (!q)
+        return 0;
+    if (q->index)
+        return hindex_count(q->index, s, strlen(s));
+
+    int count = 0;
+    q_iter_t it;
+    q_iter_init(q, &it);
+    for (char *value; (value = q_iter_next(&it));)
+        count += !strcmp(value, s);
+    return count;
+}
 
-    newh->value = malloc(len + 1);
-    if (!newh->value) {
-        free(newh);
+/* Return whether queue holds the string s, false if q is NULL */
+bool q_contains(queue_t *q, const char *s)
+{
+    if (!q)
         return false;
+    if (q->index)
+        return hindex_count(q->index, s, strlen(s));
+
+    q_iter_t it;
+    q_iter_init(q, &it);
+    for (char *value; (value = q_iter_next(&it));) {
+        if (!strcmp(value, s))
+            return true;
     }
+    return false;
+}
 
-    strncpy(newh->value, s, len);
-    newh->value[len] = '\0';
+/*
+ * Snapshots of a linked list share its elements: one shows size elements
+ * from head, which stay in place as long as the queue only inserts at
+ * either end and removes from its head.  Removed elements that a snapshot
+ * still shows are kept aside, with their links, until the queue has no
+ * snapshot left.  Before anything else relinks or releases elements, every
+ * snapshot of the queue is detached with a private copy of what it shows.
+ */
+struct SNAPSHOT {
+    queue_t *q;            /* Queue sharing its elements, NULL once detached */
+    struct SNAPSHOT *next; /* Next snapshot attached to the same queue */
+    list_ele_t *head;      /* First element shown */
+    int size;              /* Number of elements shown, -1 once lost */
+    int front;             /* Elements of q ahead of those shown still in q */
+    int live;              /* Elements shown that are still in q */
+    queue_t *copy;         /* Private copy of the elements, once detached */
+};
 
-    newh->next = q->head;
-    q->head = newh;
+/* Snapshots attached to a queue, and the elements kept for them */
+typedef struct SNAP_SET {
+    q_snapshot_t *list;
+    list_ele_t **retired; /* Elements removed from the queue, still shown */
+    int nretired;
+    int retired_cap;
+} snap_set_t;
 
-    if (!q->tail)
-        q->tail = newh;
+/* Initial number of elements that can be kept for the snapshots */
+#define SNAP_MIN_RETIRED 64
 
-    q->size++;
+/* Elements inserted at head of q come ahead of those of every snapshot */
+static void snap_insert_head(queue_t *q, int n)
+{
+    if (!q->snaps)
+        return;
+    for (q_snapshot_t *s = q->snaps->list; s; s = s->next)
+        s->front += n;
+}
 
-    return true;
+/* Release the elements kept for the snapshots of q, which has none left */
+static void snap_set_release(queue_t *q)
+{
+    snap_set_t *set = q->snaps;
+
+    for (int i = 0; i < set->nretired; i++)
+        ele_free(q, set->retired[i]);
+    free(set->retired);
+    free(set);
+    q->snaps = NULL;
 }
 
 /*
- * Attempt to insert element at tail of queue.
- * Return true if successful.
- * Return false if q is NULL or could not allocate space.
- * Argument s points to the string to be stored.
- * The function must explicitly allocate space and copy the string into it.
+ * Copy the strings of a walk to a new linked list with the given layout.
+ * Return NULL if could not allocate space.
  */
-bool q_insert_tail(queue_t *q, char *s)
+static queue_t *copy_walk(int layout, q_iter_t *it)
+{
+    queue_t *copy = queue_new(layout, NULL);
+    NULL_PTR_GUARD(copy);
+
+    for (char *s; (s = q_iter_next(it));) {
+        if (!q_insert_tail(copy, s)) {
+            q_free(copy);
+            return NULL;
+        }
+    }
+    return copy;
+}
+
+/* Give s a private copy of what it shows, or lose it if there is no room */
+static void snap_detach(q_snapshot_t *s)
+{
+    q_iter_t it;
+
+    q_snapshot_iter_init(s, &it);
+    s->copy = copy_walk(s->q->layout, &it);
+    s->q = NULL;
+    s->head = s->copy ? s->copy->head : NULL;
+    if (!s->copy)
+        s->size = -1;
+}
+
+/* Detach every snapshot of q, before q relinks or releases elements */
+static void snap_detach_all(queue_t *q)
+{
+    if (!q->snaps)
+        return;
+    for (q_snapshot_t *s = q->snaps->list; s; s = s->next)
+        snap_detach(s);
+    snap_set_release(q);
+}
+
+/*
+ * Dispose of e, just unlinked from head of q: keep it while a snapshot
+ * shows it, or else release it.
+ */
+static void ele_drop(queue_t *q, list_ele_t *e)
+{
+    bool shown = false;
+    snap_set_t *set = q->snaps;
+
+    if (!set) {
+        ele_free(q, e);
+        return;
+    }
+
+    for (q_snapshot_t *s = set->list; s; s = s->next) {
+        if (s->front) {
+            s->front--;
+        } else if (s->live) {
+            s->live--;
+            shown = true;
+        }
+    }
+    if (!shown) {
+        ele_free(q, e);
+        return;
+    }
+
+    if (set->nretired == set->retired_cap) {
+        int cap = set->retired_cap ? 2 * set->retired_cap : SNAP_MIN_RETIRED;
+        list_ele_t **retired = malloc(cap * sizeof(list_ele_t *));
+        if (!retired) {
+            /* Still linked to e, the snapshots can be copied instead */
+            snap_detach_all(q);
+            ele_free(q, e);
+            return;
+        }
+        memcpy(retired, set->retired, set->nretired * sizeof(list_ele_t *));
+        free(set->retired);
+        set->retired = retired;
+        set->retired_cap = cap;
+    }
+    set->retired[set->nretired++] = e;
+}
+
+q_snapshot_t *q_snapshot(queue_t *q)
 {
     NULL_PTR_GUARD(q);
-    size_t len = strlen(s);
+    q_snapshot_t *s = malloc(sizeof(q_snapshot_t));
+    NULL_PTR_GUARD(s);
 
-    list_ele_t *newt = malloc(sizeof(list_ele_t));
-    NULL_PTR_GUARD(newt);
-    newt->next = NULL;
-    newt->value = malloc(len + 1);
-    if (!newt->value) {
-        free(newt->value);
-        free(newt);
-        return false;
+    s->q = NULL;
+    s->next = NULL;
+    s->front = 0;
+    s->live = 0;
+    s->copy = NULL;
+
+    /* Backends keep their elements their own way, copy them at once */
+    if (q->backend) {
+        q_iter_t it;
+        q_iter_init(q, &it);
+        s->copy = copy_walk(POOL_LAYOUT, &it);
+        if (!s->copy) {
+            free(s);
+            return NULL;
+        }
+        s->head = s->copy->head;
+        s->size = s->copy->size;
+        return s;
     }
 
-    strncpy(newt->value, s, len);
-    newt->value[len] = '\0';
+    if (!q->snaps) {
+        q->snaps = malloc(sizeof(snap_set_t));
+        if (!q->snaps) {
+            free(s);
+            return NULL;
+        }
+        memset(q->snaps, 0, sizeof(snap_set_t));
+    }
 
-    if (!q->tail) {  // empty queue
-        q->tail = newt;
-        q->head = newt;
-    } else {
-        q->tail->next = newt;
-        q->tail = q->tail->next;
+    s->q = q;
+    s->head = q->head;
+    s->size = q->size;
+    s->live = q->size;
+    s->next = q->snaps->list;
+    q->snaps->list = s;
+    return s;
+}
+
+void q_snapshot_free(q_snapshot_t *s)
+{
+    if (!s)
+        return;
+
+    if (s->q) {
+        q_snapshot_t **indirect = &s->q->snaps->list;
+        while (*indirect != s)
+            indirect = &(*indirect)->next;
+        *indirect = s->next;
+        if (!s->q->snaps->list)
+            snap_set_release(s->q);
     }
+    q_free(s->copy);
+    free(s);
+}
 
-    q->size++;
+int q_snapshot_size(q_snapshot_t *s)
+{
+    NULL_PTR_GUARD(s);
+    return s->size;
+}
 
-    return true;
+bool q_has_snapshots(queue_t *q)
+{
+    return q && q->snaps;
+}
+
+void q_snapshot_iter_init(q_snapshot_t *s, q_iter_t *it)
+{
+    it->q = NULL;
+    it->node = s ? s->head : NULL;
+    it->index = s && s->size > 0 ? s->size : 0;
 }
 
 /*
- * Attempt to remove element from head of queue.
- * Return true if successful.
- * Return false if queue is NULL or empty.
- * If sp is non-NULL and an element is removed, copy the removed string to *sp
- * (up to a maximum of bufsize-1 characters, plus a null terminator.)
- * The space used by the list element and the string should be freed.
+ * Move all elements of src to the tail of dst, leaving src empty.
+ * Return false if either queue is NULL, both are the same queue, they do
+ * not share a backend and layout, or could not allocate space.
  */
-bool q_remove_head(queue_t *q, char *sp, size_t bufsize)
+bool q_concat(queue_t *dst, queue_t *src)
 {
-    list_ele_t *old_h;
-
-    if (!q || !q->head || !sp)
+    if (!dst || !src || dst == src || dst->backend != src->backend ||
+        dst->layout != src->layout)
         return false;
-    size_t ncopy = (bufsize - 1) >= strlen(q->head->value)
-                       ? strlen(q->head->value)
-                       : bufsize - 1;
-    strncpy(sp, q->head->value, ncopy);
-    sp[ncopy] = '\0';
+    if (!src->size)
+        return true;
 
-    old_h = q->head;
-    q->head = q->head->next;
-
-    /* Update q->tail if q->size == 1 */
-    /* TODO: Apply Good-Taste to the update of q->tail */
-    if (q->size == 1)
-        q->tail = NULL;
-
-    free(old_h->value);
-    free(old_h);
+    /* Appending to dst leaves its snapshots alone, not emptying src */
+    snap_detach_all(src);
+    mem_join(dst, src);
+    index_move(src, 0, dst);
+    if (dst->backend) {
+        if (dst->backend->concat(dst, src))
+            return true;
+        /* The strings counted as moved stayed where they were */
+        index_drop(dst);
+        index_drop(src);
+        return false;
+    }
 
-    q->size--;
+    if (dst->tail)
+        dst->tail->next = src->head;
+    else
+        dst->head = src->head;
+    dst->tail = src->tail;
+    dst->size += src->size;
 
+    src->head = NULL;
+    src->tail = NULL;
+    src->size = 0;
     return true;
 }
 
 /*
- * Return number of elements in queue.
- * Return 0 if q is NULL or empty
+ * Keep the first n elements in q and move the others to the tail of out.
+ * Return false if either queue is NULL, both are the same queue, they do
+ * not share a backend and layout, n is negative, or could not allocate
+ * space.
  */
-int q_size(queue_t *q)
+bool q_split(queue_t *q, int n, queue_t *out)
 {
-    NULL_PTR_GUARD(q);
-    return q->size;
+    if (!q || !out || q == out || q->backend != out->backend ||
+        q->layout != out->layout || n < 0)
+        return false;
+    if (n >= q->size)
+        return true;
+
+    snap_detach_all(q);
+    mem_join(out, q);
+    index_move(q, n, out);
+    if (q->backend) {
+        if (q->backend->split(q, n, out))
+            return true;
+        index_drop(q);
+        index_drop(out);
+        return false;
+    }
+
+    /* Cut the list right after its n-th element */
+    list_ele_t *first = q->head, *old_tail = q->tail;
+    if (!n) {
+        q->head = NULL;
+        q->tail = NULL;
+    } else {
+        list_ele_t *last = q->head;
+        for (int i = 1; i < n; i++)
+            last = last->next;
+        first = last->next;
+        last->next = NULL;
+        q->tail = last;
+    }
+
+    if (out->tail)
+        out->tail->next = first;
+    else
+        out->head = first;
+    out->tail = old_tail;
+    out->size += q->size - n;
+    q->size = n;
+    return true;
 }
 
 /*
@@ -196,6 +1385,11 @@ void q_reverse(queue_t *q)
 {
     if (!q || q->size <= 1)
         return;
+    if (q->backend) {
+        q->backend->reverse(q);
+        return;
+    }
+    snap_detach_all(q);
 
     /* cursor point to head of elements that are already reversed */
     list_ele_t *cursor = NULL;
@@ -203,6 +1397,7 @@ void q_reverse(queue_t *q)
 
     for (q->tail = q->head; q->head;) {
         tmp = q->head->next;
+        ele_prefetch_next(tmp);
         q->head->next = cursor;
         cursor = q->head;
         q->head = tmp;
@@ -210,48 +1405,129 @@ void q_reverse(queue_t *q)
     q->head = cursor;
 }
 
-/* The caller function preparing merge_sort operation */
-static void merge_sort(queue_t *q)
+/* Compare two entries of a relayout table by the address of their element */
+static int slot_cmp(const void *a, const void *b)
 {
-    if (!q || q->size <= 1)
-        return;
+    uintptr_t x = (uintptr_t) ((const relayout_slot_t *) a)->e;
+    uintptr_t y = (uintptr_t) ((const relayout_slot_t *) b)->e;
+    return (x > y) - (x < y);
+}
 
-    q->head = do_merge_sort(q->head);
-    while (q->tail->next)
-        q->tail = q->tail->next;
+/*
+ * Move the elements of queue so that they follow each other in memory in
+ * the order of the list, over the addresses they already occupy.
+ * Return false if q is NULL or could not allocate space.
+ */
+bool q_relayout(queue_t *q)
+{
+    NULL_PTR_GUARD(q);
 
-    return;
+    /* Backends store their own way, and these layouts vary in size */
+    if (q->backend || q->layout == INLINE_LAYOUT ||
+        q->layout == ARENA_LAYOUT || q->size <= 1)
+        return true;
+    snap_detach_all(q);
+
+    relayout_slot_t *slots = malloc(q->size * sizeof(relayout_slot_t));
+    NULL_PTR_GUARD(slots);
+
+    int i = 0;
+    for (list_ele_t *e = q->head; e; e = e->next, i++) {
+        slots[i].e = e;
+        slots[i].pos = i;
+    }
+    qsort(slots, q->size, sizeof(relayout_slot_t), slot_cmp);
+
+    /*
+     * slots[k].e is now the k-th lowest address, holding the pos-th
+     * element of the list, which belongs at the pos-th lowest address.
+     * Every swap puts one element in its place.
+     */
+    size_t size = sizeof(list_ele_t);
+    if (q->layout == SSO_LAYOUT)
+        size += SSO_CAPACITY;
+    char tmp[sizeof(list_ele_t) + SSO_CAPACITY];
+    for (int k = 0; k < q->size; k++) {
+        while (slots[k].pos != k) {
+            int pos = slots[k].pos;
+            list_ele_t *a = slots[k].e, *b = slots[pos].e;
+            bool a_inline = a->value == a->inline_value;
+            bool b_inline = b->value == b->inline_value;
+
+            memcpy(tmp, a, size);
+            memcpy(a, b, size);
+            memcpy(b, tmp, size);
+            /* Strings kept in the element moved along with it */
+            if (b_inline)
+                a->value = a->inline_value;
+            if (a_inline)
+                b->value = b->inline_value;
+
+            slots[k].pos = slots[pos].pos;
+            slots[pos].pos = pos;
+        }
+    }
+
+    for (int k = 0; k < q->size - 1; k++)
+        slots[k].e->next = slots[k + 1].e;
+    slots[q->size - 1].e->next = NULL;
+    q->head = slots[0].e;
+    q->tail = slots[q->size - 1].e;
+
+    free(slots);
+    return true;
 }
 
-/* Do the actual operation of merge_sort */
-/* FIXME: Stack overflow, the end condition doesn't work */
-static list_ele_t *do_merge_sort(list_ele_t *head)
+/* Return the bytes of removed strings queue still holds, 0 if q is NULL */
+size_t q_dead_bytes(queue_t *q)
 {
-    if (!head->next)
-        return head;
-    /* Do split using tortoise and hare algorithm */
-    list_ele_t *slow = head;
-    list_ele_t *fast = head->next;
+    if (!q || !q->backend || !q->backend->dead_bytes)
+        return 0;
+    return q->backend->dead_bytes(q);
+}
+
+/* Sort with the backend, or the registered method for the linked list */
+static void sort_dispatch(queue_t *q)
+{
+    if (!q || q->size <= 1)
+        return;
 
-    while (fast && fast->next) {
-        slow = slow->next;
-        fast = fast->next->next;
+    if (q->backend) {
+        q->backend->sort(q);
+    } else {
+        snap_detach_all(q);
+        list_sort_method(q);
     }
-    fast = slow->next;
-    slow->next = NULL;
+}
+
+/* Bottom-up merge sort, without recursion nor split passes */
+static void merge_sort(queue_t *q)
+{
+    if (!q || q->size <= 1)
+        return;
 
-    /* Sort each list */
+    merge_bins_t mb;
+    merge_bins_init(&mb, do_merge, NULL);
+    for (list_ele_t *e = q->head; e;) {
+        list_ele_t *node = e;
+        e = e->next;
+        ele_prefetch(e);
+        node->next = NULL;
+        merge_bins_add(&mb, node);
+    }
 
-    list_ele_t *l1 = do_merge_sort(head);
-    list_ele_t *l2 = do_merge_sort(fast);
-    return do_merge(l1, l2);
+    run_t sorted = merge_bins_finish(&mb);
+    q->head = sorted.head;
+    q->tail = sorted.tail;
 }
-/* Do the merge part */
-static list_ele_t *do_merge(list_ele_t *l1, list_ele_t *l2)
+
+/* Do the merge part, see run_merge_t */
+static run_t do_merge(void *priv, run_t a, run_t b)
 {
+    list_ele_t *l1 = a.head, *l2 = b.head;
     list_ele_t *head;
 
-    if (strcmp(l1->value, l2->value) <= 0) {
+    if (ele_cmp(l1, l2) <= 0) {
         head = l1;
         l1 = l1->next;
     } else {
@@ -261,21 +1537,73 @@ static list_ele_t *do_merge(list_ele_t *l1, list_ele_t *l2)
     for (list_ele_t *cur = head;; cur = cur->next) {
         if (!l1) {
             cur->next = l2;
-            break;
+            return (run_t){head, b.tail};
         }
         if (!l2) {
             cur->next = l1;
-            break;
+            return (run_t){head, a.tail};
         }
-        if (strcmp(l1->value, l2->value) <= 0) {
+        /* The run moved along is compared again next */
+        if (ele_cmp(l1, l2) <= 0) {
             cur->next = l1;
             l1 = l1->next;
+            ele_prefetch(l1);
         } else {
             cur->next = l2;
             l2 = l2->next;
+            ele_prefetch(l2);
         }
     }
-    return head;
+}
+
+/*
+ * Pending runs of pending_merge_sort().  Each size is a power of two, with
+ * at most two runs of any size, so this bounds lists below 2^63 elements.
+ */
+#define SORT_PENDING (2 * MERGE_BINS)
+
+/*
+ * The merge schedule of list_sort() in list_sort.c, for the LIST_SORT
+ * method.  Elements have no prev link to chain the pending runs with, so
+ * the runs sit on an array instead, newest last.
+ */
+static void pending_merge_sort(queue_t *q)
+{
+    if (!q || q->size <= 1)
+        return;
+
+    run_t pending[SORT_PENDING];
+    int top = 0;
+    size_t count = 0;
+
+    for (list_ele_t *e = q->head; e;) {
+        int i = top - 1;
+        size_t bits = count;
+        for (; bits & 1; bits >>= 1)
+            i--;
+
+        /* Older run on the left keeps the sort stable */
+        if (bits) {
+            pending[i - 1] = do_merge(NULL, pending[i - 1], pending[i]);
+            for (; i < top - 1; i++)
+                pending[i] = pending[i + 1];
+            top--;
+        }
+
+        list_ele_t *node = e;
+        e = e->next;
+        ele_prefetch(e);
+        node->next = NULL;
+        pending[top++] = (run_t){node, node};
+        count++;
+    }
+
+    run_t sorted = pending[--top];
+    while (top)
+        sorted = do_merge(NULL, pending[--top], sorted);
+
+    q->head = sorted.head;
+    q->tail = sorted.tail;
 }
 
 static void selection_sort(queue_t *q)
@@ -294,7 +1622,7 @@ static void bubble_sort(queue_t *q)
         q->tail = (*in_h);
         in_h = &q->head;
         for (int j = 0; j < q->size - 1 - i; j++) {
-            if (strcmp((*in_h)->value, (*in_h)->next->value) > 0) {
+            if (ele_cmp(*in_h, (*in_h)->next) > 0) {
                 tmp = (*in_h)->next;
                 (*in_h)->next = tmp->next;
                 tmp->next = (*in_h);
@@ -315,5 +1643,29 @@ void q_sort_register_method(int sort_method)
     if (sort_method < MERGE_SORT || sort_method >= SORT_METHOD_NUM)
         sort_method = MERGE_SORT;
 
-    q_sort = sort_func[sort_method];
+    list_sort_method = sort_func[sort_method];
+}
+
+/*
+ * Register the element layout of queues created by later calls to q_new().
+ */
+void q_layout_register(int layout)
+{
+    /* Sanity check */
+    if (layout < POOL_LAYOUT || layout >= LAYOUT_NUM)
+        layout = POOL_LAYOUT;
+
+    new_layout = layout;
+}
+
+/*
+ * Register the backend of queues created by later calls to q_new().
+ */
+void q_backend_register(int backend)
+{
+    /* Sanity check */
+    if (backend < LIST_BACKEND || backend >= BACKEND_NUM)
+        backend = LIST_BACKEND;
+
+    new_backend = backend;
 }
@@ -20,19 +20,77 @@ typedef struct ELE {
      */
     char *value;
     struct ELE *next;
+    /* Length of value, so it never has to be scanned for its terminator */
+    size_t len;
+    /* String bytes, when the layout keeps them in the element itself */
+    char inline_value[];
 } list_ele_t;
 
+/* Alternative storage of the elements, see backend.h */
+struct BACKEND;
+struct MEM;
+struct SNAP_SET;
+struct HINDEX;
+
 /* Queue structure */
-typedef struct {
+typedef struct QUEUE {
     list_ele_t *head; /* Linked list of elements */
     list_ele_t *tail;
     int size;
+    int layout; /* How elements and their strings are allocated */
+
+    /* Allocators of the elements, shared with the queues on this list */
+    struct MEM *mem;
+    struct QUEUE *mem_next;
+
+    /* Backend keeping the elements instead, NULL for the linked list */
+    const struct BACKEND *backend;
+    void *store; /* Private storage of the backend */
+
+    /* Snapshots sharing the elements, NULL if none, see q_snapshot() */
+    struct SNAP_SET *snaps;
+
+    /* Counts of the strings, NULL if not indexed, see q_index_enable() */
+    struct HINDEX *index;
 } queue_t;
 
+/* Position of a walk over the strings of a queue, from head to tail */
+typedef struct {
+    queue_t *q;
+    void *node; /* Where the walk is, meaning depends on the backend */
+    int index;
+} q_iter_t;
+
+/* Enumeration for different layouts of list elements */
+enum {
+    POOL_LAYOUT,   /* Element from the queue's pool, string allocated apart */
+    INLINE_LAYOUT, /* Element and string bytes share a single allocation */
+    SSO_LAYOUT,    /* Short strings kept in the pooled element itself */
+    INTERN_LAYOUT, /* Pooled element, equal strings shared through intern.h */
+    ARENA_LAYOUT,  /* Element and string bytes bump-allocated from the arena */
+
+    LAYOUT_NUM,
+};
+
+/* Enumeration for different backends storing the elements of a queue */
+enum {
+    LIST_BACKEND,     /* Singly-linked list of list_ele_t */
+    UNROLLED_BACKEND, /* Linked list of blocks, each holding many strings */
+    RING_BACKEND,     /* Growable circular array of string pointers */
+    DLIST_BACKEND,    /* Doubly-linked list, reversed by a direction flag */
+    COMPACT_BACKEND,  /* Array of 32-bit linked nodes, strings packed apart */
+    HEAP_BACKEND,     /* Binary min-heap of string pointers, smallest at head */
+    SKIPLIST_BACKEND, /* Skip list keeping the strings sorted, with ranks */
+
+    BACKEND_NUM,
+};
+
 /* Operations on queue */
 
 /*
  * Create empty queue.
+ * Its elements are kept by the backend registered by q_backend_register(),
+ * following the layout registered by q_layout_register().
  * Return NULL if could not allocate space.
  */
 queue_t *q_new();
@@ -40,9 +98,23 @@ queue_t *q_new();
 /*
  * Free ALL storage used by queue.
  * No effect if q is NULL
+ * With q_async_free set, a large queue drawing on allocators of its own is
+ * only detached, and released later by a background thread.
  */
 void q_free(queue_t *q);
 
+/*
+ * Whether q_free() hands large queues over to a background thread instead
+ * of releasing them before returning (default: 0).
+ */
+extern int q_async_free;
+
+/*
+ * Wait until every queue handed over by q_free() has been released, so
+ * the storage they used is back.
+ */
+void q_free_wait();
+
 /*
  * Attempt to insert element at head of queue.
  * Return true if successful.
@@ -61,6 +133,24 @@ bool q_insert_head(queue_t *q, char *s);
  */
 bool q_insert_tail(queue_t *q, char *s);
 
+/*
+ * Attempt to insert the n strings of sv at head of queue, in order, as n
+ * calls to q_insert_head() would.  Like q_insert_head(), an empty string is
+ * rejected, and stops the batch there.
+ * Return the number of strings inserted, less than n only if q is NULL,
+ * could not allocate space, or the next string is empty; the strings
+ * before that one are inserted.
+ */
+int q_insert_head_n(queue_t *q, char **sv, int n);
+
+/*
+ * Attempt to insert the n strings of sv at tail of queue, in order, as n
+ * calls to q_insert_tail() would.
+ * Return the number of strings inserted, less than n only if q is NULL or
+ * could not allocate space; the strings before that one are inserted.
+ */
+int q_insert_tail_n(queue_t *q, char **sv, int n);
+
 /*
  * Attempt to remove element from head of queue.
  * Return true if successful.
@@ -71,12 +161,195 @@ bool q_insert_tail(queue_t *q, char *s);
  */
 bool q_remove_head(queue_t *q, char *sp, size_t bufsize);
 
+/*
+ * Attempt to remove element from tail of queue.
+ * Same contract as q_remove_head().  O(1) for every backend but the
+ * singly-linked list, which has to walk to the element before the tail.
+ */
+bool q_remove_tail(queue_t *q, char *sp, size_t bufsize);
+
+/*
+ * Attempt to remove element from head of queue, without copying its string.
+ * Return the string, or NULL if queue is NULL or empty.  The string is
+ * read-only, as INTERN_LAYOUT shares it with the elements holding the same
+ * string, and must be given back with q_release() before q is freed.
+ */
+const char *q_remove_head_take(queue_t *q);
+
+/*
+ * Attempt to remove up to n elements from head of queue at once.
+ * If sv is non-NULL, it receives their strings in queue order, to be
+ * given back with q_release() as for q_remove_head_take().  Otherwise the
+ * strings are freed.
+ * Return the number of elements removed, 0 if q is NULL or empty.
+ */
+int q_remove_head_n(queue_t *q, const char **sv, int n);
+
+/*
+ * Release a string returned by q_remove_head_take() on the same queue.
+ * No effect if s is NULL.
+ */
+void q_release(queue_t *q, const char *s);
+
+/*
+ * Return the string stored at the head of queue, without removing it.
+ * Return NULL if q is NULL or empty.
+ * The string remains owned by the queue.
+ */
+char *q_peek_head(queue_t *q);
+
+/*
+ * Attempt to insert element into a queue of HEAP_BACKEND, in O(log n).
+ * Return true if successful.
+ * Return false if q is NULL, is not a heap, or could not allocate space.
+ * The string is copied, as for q_insert_tail().
+ */
+bool q_push(queue_t *q, char *s);
+
+/*
+ * Attempt to remove the smallest string from a queue of HEAP_BACKEND, in
+ * O(log n).  Same contract as q_remove_head(), and false also if q is not
+ * a heap.
+ */
+bool q_pop_min(queue_t *q, char *sp, size_t bufsize);
+
 /*
  * Return number of elements in queue.
  * Return 0 if q is NULL or empty
  */
 int q_size(queue_t *q);
 
+/*
+ * Start a walk over the strings of queue, from head to tail.
+ * A NULL queue is walked as an empty one.
+ * The queue must not be modified until the walk is over.
+ */
+void q_iter_init(queue_t *q, q_iter_t *it);
+
+/*
+ * Return the next string of the walk, or NULL once past the tail.
+ * The string remains owned by the queue.
+ */
+char *q_iter_next(q_iter_t *it);
+
+/*
+ * Start a walk over the strings of queue from the n-th one, 0 being the
+ * head, continued by q_iter_next().  The walk is empty if n is out of
+ * range.  O(log n) for SKIPLIST_BACKEND, which keeps the strings sorted,
+ * so q_iter_init_at(q, it, q_rank(q, lo)) walks from the first string not
+ * less than lo.  Other queues walk to the n-th string.
+ */
+void q_iter_init_at(queue_t *q, q_iter_t *it, int n);
+
+/*
+ * Return the n-th string of queue, 0 being the head, without removing it.
+ * Return NULL if q is NULL or n is out of range.
+ * O(log n) for SKIPLIST_BACKEND, a walk from the head for other queues.
+ */
+char *q_get_nth(queue_t *q, int n);
+
+/*
+ * Return the number of strings of queue less than s, which is the
+ * position s would be inserted at in a sorted queue.
+ * Return 0 if q is NULL.
+ * O(log n) for SKIPLIST_BACKEND, a walk over every string for other queues.
+ */
+int q_rank(queue_t *q, const char *s);
+
+/*
+ * Index the strings of queue by hash, so q_contains() and q_count() take
+ * O(1) instead of walking it.  Every later insertion and removal keeps the
+ * index up to date.  Should the index fail to grow, it is dropped and the
+ * queue walked again.
+ * Return true if successful, including when q is already indexed.
+ * Return false if q is NULL or could not allocate space.
+ */
+bool q_index_enable(queue_t *q);
+
+/* Drop the index of queue.  No effect if q is NULL or not indexed */
+void q_index_disable(queue_t *q);
+
+/*
+ * Return whether queue holds the string s.
+ * Return false if q is NULL.
+ */
+bool q_contains(queue_t *q, const char *s);
+
+/*
+ * Return the number of strings of queue equal to s.
+ * Return 0 if q is NULL.
+ */
+int q_count(queue_t *q, const char *s);
+
+/* Point-in-time view of the strings of a queue */
+typedef struct SNAPSHOT q_snapshot_t;
+
+/*
+ * Take a snapshot of queue, showing its strings as they are now whatever
+ * happens to the queue later.  A linked list shares its elements with the
+ * snapshot in O(1): inserting at either end and removing from the head
+ * copy nothing, and elements the snapshot shows are kept when removed.
+ * Any other change, and freeing the queue, first gives the snapshot a
+ * private copy of what it shows.  Queues of other backends are copied
+ * right away.
+ * Return NULL if q is NULL or could not allocate space.
+ */
+q_snapshot_t *q_snapshot(queue_t *q);
+
+/*
+ * Drop a snapshot.  Elements kept for the snapshots of a queue go away
+ * once it has none left.  No effect if s is NULL.
+ */
+void q_snapshot_free(q_snapshot_t *s);
+
+/*
+ * Return the number of strings shown by the snapshot.
+ * Return -1 if a private copy was needed but could not be allocated, in
+ * which case it shows nothing.  Return 0 if s is NULL.
+ */
+int q_snapshot_size(q_snapshot_t *s);
+
+/*
+ * Start a walk over the strings of a snapshot, continued by q_iter_next().
+ * A NULL snapshot is walked as an empty one.
+ */
+void q_snapshot_iter_init(q_snapshot_t *s, q_iter_t *it);
+
+/*
+ * Return whether snapshots share elements with queue, in which case the
+ * next change other than inserting at either end or removing from the
+ * head first allocates private copies for them.
+ * Return false if q is NULL.
+ */
+bool q_has_snapshots(queue_t *q);
+
+/*
+ * Move all elements of src to the tail of dst, leaving src empty.
+ * The cost depends on the backend.  The linked list, the unrolled list and
+ * the doubly-linked list relink their elements in O(1), copying no string.
+ * The ring buffer copies every string pointer into dst, and the heap and
+ * the skip list put each string in its place in O(log n), so O(n log n)
+ * in all.  The compact backend copies the bytes of every string into dst.
+ * Return true if successful, including when src is empty.
+ * Return false if either queue is NULL, both are the same queue, they do
+ * not share a backend and layout, or could not allocate space.
+ */
+bool q_concat(queue_t *dst, queue_t *src);
+
+/*
+ * Keep the first n elements in q and move the others to the tail of out.
+ * Nothing moves if q holds n elements or fewer.  The linked list walks to
+ * the n-th element, the doubly-linked list from whichever end is closer,
+ * and the unrolled list block by block, copying the pointers of the block
+ * it cuts in two; the elements moved are then relinked in O(1).  Other
+ * backends move each element as q_concat() does.
+ * Return true if successful.
+ * Return false if either queue is NULL, both are the same queue, they do
+ * not share a backend and layout, n is negative, or could not allocate
+ * space.
+ */
+bool q_split(queue_t *q, int n, queue_t *out);
+
 /*
  * Reverse elements in queue
  * No effect if q is NULL or empty
@@ -86,26 +359,67 @@ int q_size(queue_t *q);
  */
 void q_reverse(queue_t *q);
 
+/*
+ * Move the elements of queue so that they lie in memory in the order of
+ * the list, which lets walks over it stream through memory.  The elements
+ * keep to the addresses the queue already holds, and no string is copied.
+ * Queues of other backends, and of layouts whose elements vary in size,
+ * are left as they are.
+ * Return true if successful.
+ * Return false if q is NULL or could not allocate space.
+ */
+bool q_relayout(queue_t *q);
+
+/*
+ * Whether q_free(), q_reverse(), the merge sorts and the walks of
+ * q_iter_next() hint the cache about the elements ahead on the linked list
+ * (default: 0).
+ */
+extern int q_prefetch;
+
+/*
+ * Return the bytes of removed strings that queue still holds, which
+ * COMPACT_BACKEND reclaims only once its string heap runs out of room.
+ * Return 0 for other queues, and if q is NULL.
+ */
+size_t q_dead_bytes(queue_t *q);
+
 /* Enumeration for different sorting methods */
 enum {
     MERGE_SORT,
     SELECTION_SORT,
     BUBBLE_SORT,
+    LIST_SORT, /* Linux list_sort(), keeping merges 2:1 balanced */
 
     SORT_METHOD_NUM,
 };
 
 /*
- * Function pointer to actual sorting method.
+ * Function pointer to the sorting entry point.
+ * The linked list is sorted by the method registered with
+ * q_sort_register_method(); other backends use their own algorithm.
  * Sort elements of queue in ascending order
  * No effect if q is NULL or empty. In addition, if q has only one
  * element, do nothing.
  */
-void (*q_sort)(queue_t *q);
+extern void (*q_sort)(queue_t *q);
 
 /*
  * Register the sorting method.
  */
 void q_sort_register_method(int sort_method);
 
+/*
+ * Register the element layout of queues created by later calls to q_new().
+ * Queues already created keep their layout.
+ */
+void q_layout_register(int layout);
+
+/*
+ * Register the backend of queues created by later calls to q_new().
+ * Queues already created keep their backend.  Layouts only apply to
+ * LIST_BACKEND; the other backends manage their own storage.
+ */
+void q_backend_register(int backend);
+
 #endif /* LAB0_QUEUE_H */
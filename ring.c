@@ -0,0 +1,295 @@
+/*
+ * Ring buffer backend.
+ *
+ * Strings are kept in a circular array of pointers that doubles in size
+ * when full, so insertions at either end and removal from the head are
+ * amortized O(1) without any per-element node.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "backend.h"
+#include "harness.h"
+
+/* Initial number of slots, must be a power of two */
+#define RING_MIN_CAPACITY 16
+
+typedef struct {
+    char **values;   /* Circular array of string pointers */
+    size_t capacity; /* Number of slots, always a power of two */
+    size_t head;     /* Slot of the string at the head of the queue */
+} ring_t;
+
+/* Slot of the i-th string from the head */
+#define RING_SLOT(r, i) (((r)->head + (i)) & ((r)->capacity - 1))
+
+static inline void swap_value(char **a, char **b)
+{
+    char *tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+static bool ring_init(queue_t *q)
+{
+    ring_t *r = malloc(sizeof(ring_t));
+    if (!r)
+        return false;
+    r->values = malloc(RING_MIN_CAPACITY * sizeof(char *));
+    if (!r->values) {
+        free(r);
+        return false;
+    }
+
+    r->capacity = RING_MIN_CAPACITY;
+    r->head = 0;
+    q->store = r;
+    return true;
+}
+
+static void ring_release(queue_t *q)
+{
+    ring_t *r = q->store;
+
+    for (size_t i = 0; i < q->size; i++)
+        free(r->values[RING_SLOT(r, i)]);
+    free(r->values);
+    free(r);
+}
+
+/* Double the capacity, moving the strings to the start of the new array */
+static bool ring_grow(queue_t *q)
+{
+    ring_t *r = q->store;
+    char **values = malloc(2 * r->capacity * sizeof(char *));
+    if (!values)
+        return false;
+
+    /* The strings from head to the end of the array, then the wrapped ones */
+    size_t first = r->capacity - r->head;
+    memcpy(values, r->values + r->head, first * sizeof(char *));
+    memcpy(values + first, r->values, r->head * sizeof(char *));
+
+    free(r->values);
+    r->values = values;
+    r->capacity *= 2;
+    r->head = 0;
+    return true;
+}
+
+static bool ring_insert_head(queue_t *q, const char *s, size_t len)
+{
+    ring_t *r = q->store;
+
+    if (q->size == r->capacity && !ring_grow(q))
+        return false;
+    char *value = backend_copy_string(s, len);
+    if (!value)
+        return false;
+
+    r->head = (r->head - 1) & (r->capacity - 1);
+    r->values[r->head] = value;
+    q->size++;
+    return true;
+}
+
+static bool ring_insert_tail(queue_t *q, const char *s, size_t len)
+{
+    ring_t *r = q->store;
+
+    if (q->size == r->capacity && !ring_grow(q))
+        return false;
+    char *value = backend_copy_string(s, len);
+    if (!value)
+        return false;
+
+    r->values[RING_SLOT(r, q->size)] = value;
+    q->size++;
+    return true;
+}
+
+static char *ring_take_head(queue_t *q)
+{
+    ring_t *r = q->store;
+    char *value = r->values[r->head];
+
+    r->head = RING_SLOT(r, 1);
+    q->size--;
+    return value;
+}
+
+static char *ring_take_tail(queue_t *q)
+{
+    ring_t *r = q->store;
+
+    q->size--;
+    return r->values[RING_SLOT(r, q->size)];
+}
+
+static char *ring_peek_head(queue_t *q)
+{
+    ring_t *r = q->store;
+    return r->values[r->head];
+}
+
+static void ring_reverse(queue_t *q)
+{
+    ring_t *r = q->store;
+
+    for (size_t i = 0, j = q->size - 1; i < j; i++, j--)
+        swap_value(&r->values[RING_SLOT(r, i)], &r->values[RING_SLOT(r, j)]);
+}
+
+/* Make room for n strings in all, doubling the capacity as needed */
+static bool ring_reserve(queue_t *q, size_t n)
+{
+    ring_t *r = q->store;
+
+    while (r->capacity < n) {
+        if (!ring_grow(q))
+            return false;
+    }
+    return true;
+}
+
+/* Copy the n string pointers of src from its i-th one to the tail of dst */
+static void ring_move(queue_t *dst, queue_t *src, size_t i, size_t n)
+{
+    ring_t *d = dst->store, *s = src->store;
+
+    for (size_t k = 0; k < n; k++)
+        d->values[RING_SLOT(d, dst->size + k)] = s->values[RING_SLOT(s, i + k)];
+    dst->size += n;
+    src->size -= n;
+}
+
+static bool ring_concat(queue_t *dst, queue_t *src)
+{
+    if (!ring_reserve(dst, dst->size + src->size))
+        return false;
+
+    ring_move(dst, src, 0, src->size);
+    ((ring_t *) src->store)->head = 0;
+    return true;
+}
+
+static bool ring_split(queue_t *q, int n, queue_t *out)
+{
+    if (!ring_reserve(out, out->size + q->size - n))
+        return false;
+
+    ring_move(out, q, n, q->size - n);
+    return true;
+}
+
+/* Reverse the n pointers starting at a, used to rotate the array */
+static void reverse_array(char **a, size_t n)
+{
+    for (size_t i = 0, j = n - 1; n && i < j; i++, j--)
+        swap_value(&a[i], &a[j]);
+}
+
+/* Below this many strings, insertion sort beats partitioning */
+#define INSERTION_THRESHOLD 16
+
+/*
+ * Quick sort of the n pointers starting at a, in place.
+ * The smaller partition is sorted recursively and the larger one in the
+ * loop, bounding the depth of recursion to O(log n).
+ */
+static void quick_sort(char **a, size_t n)
+{
+    while (n > INSERTION_THRESHOLD) {
+        /* Median of first, middle and last string becomes the pivot */
+        char **m = a + n / 2, **z = a + n - 1;
+        if (strcmp(*m, *a) < 0)
+            swap_value(m, a);
+        if (strcmp(*z, *m) < 0) {
+            swap_value(z, m);
+            if (strcmp(*m, *a) < 0)
+                swap_value(m, a);
+        }
+        swap_value(m, a);
+        char *pivot = *a;
+
+        /* Hoare partition, stopping on strings equal to the pivot */
+        size_t i = 0, j = n;
+        for (;;) {
+            while (strcmp(a[++i], pivot) < 0 && i < n - 1)
+                ;
+            while (strcmp(pivot, a[--j]) < 0)
+                ;
+            if (i >= j)
+                break;
+            swap_value(&a[i], &a[j]);
+        }
+        swap_value(&a[0], &a[j]);
+
+        /* Pivot is final at j */
+        if (j < n - j - 1) {
+            quick_sort(a, j);
+            a += j + 1;
+            n -= j + 1;
+        } else {
+            quick_sort(a + j + 1, n - j - 1);
+            n = j;
+        }
+    }
+
+    for (size_t i = 1; i < n; i++) {
+        char *value = a[i];
+        size_t j = i;
+        for (; j > 0 && strcmp(a[j - 1], value) > 0; j--)
+            a[j] = a[j - 1];
+        a[j] = value;
+    }
+}
+
+static void ring_sort(queue_t *q)
+{
+    ring_t *r = q->store;
+
+    /*
+     * Rotate the strings to the start of the array with three reversals,
+     * so they form one contiguous run that can be sorted in place.
+     */
+    if (r->head) {
+        reverse_array(r->values, r->capacity);
+        reverse_array(r->values, r->capacity - r->head);
+        reverse_array(r->values + r->capacity - r->head, r->head);
+        r->head = 0;
+    }
+
+    quick_sort(r->values, q->size);
+}
+
+static void ring_iter_init(q_iter_t *it)
+{
+    it->index = 0;
+}
+
+static char *ring_iter_next(q_iter_t *it)
+{
+    ring_t *r = it->q->store;
+
+    if (it->index == it->q->size)
+        return NULL;
+    return r->values[RING_SLOT(r, it->index++)];
+}
+
+const backend_t ring_backend = {
+    .init = ring_init,
+    .release = ring_release,
+    .insert_head = ring_insert_head,
+    .insert_tail = ring_insert_tail,
+    .take_head = ring_take_head,
+    .take_tail = ring_take_tail,
+    .peek_head = ring_peek_head,
+    .reverse = ring_reverse,
+    .sort = ring_sort,
+    .concat = ring_concat,
+    .split = ring_split,
+    .iter_init = ring_iter_init,
+    .iter_next = ring_iter_next,
+};
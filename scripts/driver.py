@@ -36,7 +36,29 @@ class Tracer:
         15: "trace-15-perf",
         16: "trace-16-perf",
         17: "trace-17-complexity",
-        18: "trace-18-custom_op"
+        18: "trace-18-custom_op",
+        19: "trace-19-unrolled",
+        20: "trace-20-ring",
+        21: "trace-21-length",
+        22: "trace-22-intern",
+        23: "trace-23-arena",
+        24: "trace-24-take",
+        25: "trace-25-batch",
+        26: "trace-26-concat",
+        27: "trace-27-dlist",
+        28: "trace-28-splice",
+        29: "trace-29-compact",
+        30: "trace-30-prefetch",
+        31: "trace-31-async",
+        32: "trace-32-hugepage",
+        33: "trace-33-snap",
+        34: "trace-34-persist",
+        35: "trace-35-import",
+        36: "trace-36-heap",
+        37: "trace-37-skiplist",
+        38: "trace-38-index",
+        39: "trace-39-merge",
+        40: "trace-40-listsort"
     }
 
     traceProbs = {
@@ -57,10 +79,34 @@ class Tracer:
         15: "Trace-15",
         16: "Trace-16",
         17: "Trace-17",
-        18: "trace-18"
+        18: "trace-18",
+        19: "Trace-19",
+        20: "Trace-20",
+        21: "Trace-21",
+        22: "Trace-22",
+        23: "Trace-23",
+        24: "Trace-24",
+        25: "Trace-25",
+        26: "Trace-26",
+        27: "Trace-27",
+        28: "Trace-28",
+        29: "Trace-29",
+        30: "Trace-30",
+        31: "Trace-31",
+        32: "Trace-32",
+        33: "Trace-33",
+        34: "Trace-34",
+        35: "Trace-35",
+        36: "Trace-36",
+        37: "Trace-37",
+        38: "Trace-38",
+        39: "Trace-39",
+        40: "Trace-40"
     }
 
-    maxScores = [0, 6, 6, 6, 6, 5, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 5, 5]
+    maxScores = [0, 6, 6, 6, 6, 5, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 5, 5,
+                 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+                 5, 5, 5, 5, 5, 5]
 
     RED = '\033[91m'
     GREEN = '\033[92m'
@@ -0,0 +1,327 @@
+/*
+ * Skip list backend keeping the strings sorted.
+ *
+ * Every node is on the bottom level, which links all strings in ascending
+ * order, and on a random number of the levels above it, each holding
+ * about a quarter of the nodes of the level below.  Each link also records
+ * its span, the number of bottom-level steps it covers, so a search can
+ * count the strings it skips.  That gives sorted insertion, removal at
+ * either end, rank and select all in expected O(log n).
+ *
+ * Insertion at either end puts the string in its sorted place, after the
+ * strings equal to it.  The order follows from the strings, so sorting and
+ * reversing have no effect.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "backend.h"
+#include "harness.h"
+
+/* Most levels of a node, enough for 4^32 strings */
+#define SKIP_MAX_LEVEL 32
+
+typedef struct SNODE {
+    char *value;
+    int level; /* Number of links */
+    struct {
+        struct SNODE *next;
+        int span; /* Bottom-level steps to next, meaningless if next is NULL */
+    } link[];
+} snode_t;
+
+typedef struct {
+    snode_t *header; /* Holds no string, with SKIP_MAX_LEVEL links */
+    int level;       /* Levels in use, at least 1 */
+    uint32_t seed;   /* State of the level generator */
+} skiplist_t;
+
+/* Allocate a node with level links, for value */
+static snode_t *node_new(char *value, int level)
+{
+    snode_t *x = malloc(sizeof(snode_t) + level * sizeof(x->link[0]));
+    if (!x)
+        return NULL;
+
+    x->value = value;
+    x->level = level;
+    for (int i = 0; i < level; i++) {
+        x->link[i].next = NULL;
+        x->link[i].span = 0;
+    }
+    return x;
+}
+
+/*
+ * Draw the level of a new node, each level above the first with chance
+ * 1/4.  The generator is private, so the strings qtest draws from rand()
+ * do not depend on the queues built meanwhile.
+ */
+static int random_level(skiplist_t *sl)
+{
+    /* xorshift32 */
+    uint32_t x = sl->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sl->seed = x;
+
+    int level = 1;
+    for (; level < SKIP_MAX_LEVEL && !(x & 3); x >>= 2)
+        level++;
+    return level;
+}
+
+static bool skiplist_init(queue_t *q)
+{
+    skiplist_t *sl = malloc(sizeof(skiplist_t));
+    if (!sl)
+        return false;
+    sl->header = node_new(NULL, SKIP_MAX_LEVEL);
+    if (!sl->header) {
+        free(sl);
+        return false;
+    }
+
+    sl->level = 1;
+    sl->seed = 2463534242u;
+    q->store = sl;
+    return true;
+}
+
+static void skiplist_release(queue_t *q)
+{
+    skiplist_t *sl = q->store;
+
+    for (snode_t *x = sl->header->link[0].next, *next; x; x = next) {
+        next = x->link[0].next;
+        free(x->value);
+        free(x);
+    }
+    free(sl->header);
+    free(sl);
+}
+
+/*
+ * Link node x in its sorted place, after the strings equal to it.
+ * Nothing is allocated, so this cannot fail.
+ */
+static void skiplist_link(queue_t *q, snode_t *x)
+{
+    skiplist_t *sl = q->store;
+    snode_t *update[SKIP_MAX_LEVEL];
+    int rank[SKIP_MAX_LEVEL];
+
+    /* Last node before x on each level, and its position */
+    snode_t *p = sl->header;
+    for (int i = sl->level - 1; i >= 0; i--) {
+        rank[i] = i == sl->level - 1 ? 0 : rank[i + 1];
+        while (p->link[i].next &&
+               strcmp(p->link[i].next->value, x->value) <= 0) {
+            rank[i] += p->link[i].span;
+            p = p->link[i].next;
+        }
+        update[i] = p;
+    }
+
+    for (; sl->level < x->level; sl->level++) {
+        rank[sl->level] = 0;
+        update[sl->level] = sl->header;
+        sl->header->link[sl->level].next = NULL;
+    }
+
+    for (int i = 0; i < x->level; i++) {
+        snode_t *u = update[i];
+        int before = rank[0] - rank[i]; /* Steps from u to x, minus one */
+        x->link[i].next = u->link[i].next;
+        if (x->link[i].next)
+            x->link[i].span = u->link[i].span - before;
+        u->link[i].next = x;
+        u->link[i].span = before + 1;
+    }
+
+    /* Links above x now cover one more step */
+    for (int i = x->level; i < sl->level; i++) {
+        if (update[i]->link[i].next)
+            update[i]->link[i].span++;
+    }
+    q->size++;
+}
+
+/* Unlink and return the node at position pos, 1 being the head */
+static snode_t *skiplist_unlink(queue_t *q, int pos)
+{
+    skiplist_t *sl = q->store;
+    snode_t *update[SKIP_MAX_LEVEL];
+
+    snode_t *p = sl->header;
+    int traversed = 0;
+    for (int i = sl->level - 1; i >= 0; i--) {
+        while (p->link[i].next && traversed + p->link[i].span < pos) {
+            traversed += p->link[i].span;
+            p = p->link[i].next;
+        }
+        update[i] = p;
+    }
+
+    snode_t *x = p->link[0].next;
+    for (int i = 0; i < sl->level; i++) {
+        snode_t *u = update[i];
+        if (u->link[i].next == x) {
+            u->link[i].next = x->link[i].next;
+            u->link[i].span += x->link[i].span - 1;
+        } else if (u->link[i].next) {
+            u->link[i].span--;
+        }
+    }
+
+    while (sl->level > 1 && !sl->header->link[sl->level - 1].next)
+        sl->level--;
+    q->size--;
+    return x;
+}
+
+/* Node at position pos, 1 being the head, or NULL if there is none */
+static snode_t *skiplist_find(queue_t *q, int pos)
+{
+    skiplist_t *sl = q->store;
+    snode_t *p = sl->header;
+    int traversed = 0;
+
+    if (pos < 1 || pos > q->size)
+        return NULL;
+    for (int i = sl->level - 1; i >= 0; i--) {
+        while (p->link[i].next && traversed + p->link[i].span <= pos) {
+            traversed += p->link[i].span;
+            p = p->link[i].next;
+        }
+        if (traversed == pos)
+            break;
+    }
+    return p;
+}
+
+static bool skiplist_insert(queue_t *q, const char *s, size_t len)
+{
+    skiplist_t *sl = q->store;
+
+    char *value = backend_copy_string(s, len);
+    if (!value)
+        return false;
+    snode_t *x = node_new(value, random_level(sl));
+    if (!x) {
+        free(value);
+        return false;
+    }
+
+    skiplist_link(q, x);
+    return true;
+}
+
+static char *skiplist_take_at(queue_t *q, int pos)
+{
+    snode_t *x = skiplist_unlink(q, pos);
+    char *value = x->value;
+
+    free(x);
+    return value;
+}
+
+static char *skiplist_take_head(queue_t *q)
+{
+    return skiplist_take_at(q, 1);
+}
+
+static char *skiplist_take_tail(queue_t *q)
+{
+    return skiplist_take_at(q, q->size);
+}
+
+static char *skiplist_peek_head(queue_t *q)
+{
+    skiplist_t *sl = q->store;
+    return sl->header->link[0].next->value;
+}
+
+/* The order follows from the strings, nothing to do */
+static void skiplist_keep_order(queue_t *q) {}
+
+/* Nodes are relinked in their sorted place in the other queue */
+static bool skiplist_concat(queue_t *dst, queue_t *src)
+{
+    while (src->size)
+        skiplist_link(dst, skiplist_unlink(src, 1));
+    return true;
+}
+
+static bool skiplist_split(queue_t *q, int n, queue_t *out)
+{
+    while (q->size > n)
+        skiplist_link(out, skiplist_unlink(q, n + 1));
+    return true;
+}
+
+static void skiplist_iter_init(q_iter_t *it)
+{
+    skiplist_t *sl = it->q->store;
+    it->node = sl->header->link[0].next;
+}
+
+static char *skiplist_iter_next(q_iter_t *it)
+{
+    snode_t *x = it->node;
+    if (!x)
+        return NULL;
+
+    it->node = x->link[0].next;
+    it->index++;
+    return x->value;
+}
+
+static char *skiplist_get_nth(queue_t *q, int n)
+{
+    snode_t *x = skiplist_find(q, n + 1);
+    return x ? x->value : NULL;
+}
+
+static int skiplist_rank(queue_t *q, const char *s)
+{
+    skiplist_t *sl = q->store;
+    snode_t *p = sl->header;
+    int traversed = 0;
+
+    for (int i = sl->level - 1; i >= 0; i--) {
+        while (p->link[i].next && strcmp(p->link[i].next->value, s) < 0) {
+            traversed += p->link[i].span;
+            p = p->link[i].next;
+        }
+    }
+    return traversed;
+}
+
+static void skiplist_iter_seek(q_iter_t *it, int n)
+{
+    it->node = skiplist_find(it->q, n + 1);
+    it->index = n;
+}
+
+const backend_t skiplist_backend = {
+    .init = skiplist_init,
+    .release = skiplist_release,
+    .insert_head = skiplist_insert,
+    .insert_tail = skiplist_insert,
+    .take_head = skiplist_take_head,
+    .take_tail = skiplist_take_tail,
+    .peek_head = skiplist_peek_head,
+    .reverse = skiplist_keep_order,
+    .sort = skiplist_keep_order,
+    .concat = skiplist_concat,
+    .split = skiplist_split,
+    .iter_init = skiplist_iter_init,
+    .iter_next = skiplist_iter_next,
+    .get_nth = skiplist_get_nth,
+    .rank = skiplist_rank,
+    .iter_seek = skiplist_iter_seek,
+};
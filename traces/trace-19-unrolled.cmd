@@ -0,0 +1,56 @@
+# Test of the unrolled list as strings fill, slide within and split its blocks
+option fail 0
+option malloc 0
+option backend 1
+new
+# Fill a block from its end, then overflow into a new block at the head
+ih bear 31
+ih dolphin
+ih gerbil
+size
+nth 0 gerbil
+nth 1 dolphin
+nth 32 bear
+# Empty the head block, then make room in the next one by sliding it over
+rh gerbil
+rh dolphin
+rh bear
+it meerkat
+it squirrel
+nth 29 bear
+nth 30 meerkat
+nth 31 squirrel
+# A full block overflows into a new one at the tail
+it vulture
+rt vulture
+rt squirrel
+it vulture
+# Cut a block in two when splitting inside it
+queue other
+new
+queue main
+split 20 other
+size
+rt bear
+queue other
+rhq 10
+rh meerkat
+rh vulture
+free
+# Reverse and sort across blocks
+queue main
+ih aardvark
+it zebra
+ih bear 40
+reverse
+nth 0 zebra
+nth 19 bear
+nth 20 aardvark
+rt bear
+it bear
+sort
+rh aardvark
+rt zebra
+rhq 59
+size
+free
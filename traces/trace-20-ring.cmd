@@ -0,0 +1,41 @@
+# Test of the ring buffer as it wraps around its array and grows
+option fail 0
+option malloc 0
+option backend 2
+new
+# The first head wraps to the end of the 16 slots, the tails fill them up
+ih bear
+it dolphin 15
+size
+# Grow while the strings wrap around, keeping their order
+ih gerbil
+it meerkat
+nth 0 gerbil
+nth 1 bear
+nth 16 dolphin
+nth 17 meerkat
+# Rotate the strings through the end of the array a few times
+rh gerbil
+rh bear
+it squirrel 20
+rhq 15
+rh meerkat
+it vulture 20
+rhq 20
+nth 0 vulture
+nth 19 vulture
+rt vulture
+# Reverse and sort while the strings wrap around
+ih aardvark
+it zebra
+reverse
+rh zebra
+rt aardvark
+ih aardvark
+it zebra
+sort
+rh aardvark
+rt zebra
+rhq 19
+size
+free
@@ -0,0 +1,118 @@
+# Test of truncated copies and of strings sharing a prefix on every layout
+option fail 0
+option malloc 0
+option layout 0
+new
+it bear_cub
+it bearded_vulture
+it bear
+it be
+it aardvark_bear_dolphin_gerbil_jaguar
+sort
+rh aardvark_bear_dolphin_gerbil_jaguar
+rh be
+rh bear
+rh bear_cub
+rh bearded_vulture
+ih meerkat_panda_squirrel_vulture_wolf 3
+it aardvark_bear_dolphin_gerbil_jaguar
+option length 7
+rh meerkat
+rt aardvark
+option length 30
+rht meerkat_panda_squirrel_vulture_wolf
+option length 1024
+rh meerkat_panda_squirrel_vulture_wolf
+free
+option layout 1
+new
+it bear_cub
+it bearded_vulture
+it bear
+it be
+it aardvark_bear_dolphin_gerbil_jaguar
+sort
+rh aardvark_bear_dolphin_gerbil_jaguar
+rh be
+rh bear
+rh bear_cub
+rh bearded_vulture
+ih meerkat_panda_squirrel_vulture_wolf 3
+it aardvark_bear_dolphin_gerbil_jaguar
+option length 7
+rh meerkat
+rt aardvark
+option length 30
+rht meerkat_panda_squirrel_vulture_wolf
+option length 1024
+rh meerkat_panda_squirrel_vulture_wolf
+free
+option layout 2
+new
+it bear_cub
+it bearded_vulture
+it bear
+it be
+it aardvark_bear_dolphin_gerbil_jaguar
+sort
+rh aardvark_bear_dolphin_gerbil_jaguar
+rh be
+rh bear
+rh bear_cub
+rh bearded_vulture
+ih meerkat_panda_squirrel_vulture_wolf 3
+it aardvark_bear_dolphin_gerbil_jaguar
+option length 7
+rh meerkat
+rt aardvark
+option length 30
+rht meerkat_panda_squirrel_vulture_wolf
+option length 1024
+rh meerkat_panda_squirrel_vulture_wolf
+free
+option layout 3
+new
+it bear_cub
+it bearded_vulture
+it bear
+it be
+it aardvark_bear_dolphin_gerbil_jaguar
+sort
+rh aardvark_bear_dolphin_gerbil_jaguar
+rh be
+rh bear
+rh bear_cub
+rh bearded_vulture
+ih meerkat_panda_squirrel_vulture_wolf 3
+it aardvark_bear_dolphin_gerbil_jaguar
+option length 7
+rh meerkat
+rt aardvark
+option length 30
+rht meerkat_panda_squirrel_vulture_wolf
+option length 1024
+rh meerkat_panda_squirrel_vulture_wolf
+free
+option layout 4
+new
+it bear_cub
+it bearded_vulture
+it bear
+it be
+it aardvark_bear_dolphin_gerbil_jaguar
+sort
+rh aardvark_bear_dolphin_gerbil_jaguar
+rh be
+rh bear
+rh bear_cub
+rh bearded_vulture
+ih meerkat_panda_squirrel_vulture_wolf 3
+it aardvark_bear_dolphin_gerbil_jaguar
+option length 7
+rh meerkat
+rt aardvark
+option length 30
+rht meerkat_panda_squirrel_vulture_wolf
+option length 1024
+rh meerkat_panda_squirrel_vulture_wolf
+free
@@ -0,0 +1,35 @@
+# Test of interned strings shared between elements and queues
+option fail 0
+option malloc 0
+option layout 3
+new
+ih dolphin 1000
+it gerbil 500
+ih dolphin
+stat unique 2
+stat references 1501
+stat stored 15
+stat logical 11508
+queue other
+new
+it gerbil 100
+it meerkat
+stat unique 3
+stat references 1602
+queue main
+rhq 1000
+rh dolphin
+stat unique 2
+stat references 601
+concat other
+sort
+rh gerbil
+stat references 600
+rt meerkat
+stat unique 1
+free
+queue other
+free
+stat unique 0
+stat references 0
+stat stored 0
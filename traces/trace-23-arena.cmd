@@ -0,0 +1,45 @@
+# Test of the arena layout reusing the room of removed elements
+option fail 0
+option malloc 0
+option layout 4
+new
+it gerbil 200
+it aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_ 50
+stat blocks 3
+rhq 200
+# Strings past the freelist classes take the room of removed ones
+it aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_ 50
+rhq 50
+it aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_ 50
+rhq 50
+it aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_ 50
+rhq 50
+it aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_ 50
+rhq 50
+it aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_ 50
+rhq 50
+it aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_ 50
+rhq 50
+stat blocks 3
+# Shorter strings take part of that room, leaving the rest to others
+it bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_ 50
+rhq 50
+it bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_ 50
+rhq 50
+stat blocks 3
+rh bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_
+# Queues sharing their arenas after a concat
+queue other
+new
+it aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_ 20
+it squirrel
+queue main
+concat other
+rt squirrel
+rhq 48
+rh bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_bear_
+rh aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_aardvark_
+queue other
+free
+queue main
+free
@@ -0,0 +1,104 @@
+# Test of removing strings without copying them on every layout
+option fail 0
+option malloc 0
+option layout 0
+new
+it bear
+it aardvark_bear_dolphin_gerbil_jaguar
+ih dolphin 3
+it bear
+rht dolphin
+rhtq
+rht dolphin
+rht bear
+rht aardvark_bear_dolphin_gerbil_jaguar
+ih meerkat_panda_squirrel_vulture_wolf
+reverse
+rht bear
+rht meerkat_panda_squirrel_vulture_wolf
+size
+free
+option layout 1
+new
+it bear
+it aardvark_bear_dolphin_gerbil_jaguar
+ih dolphin 3
+it bear
+rht dolphin
+rhtq
+rht dolphin
+rht bear
+rht aardvark_bear_dolphin_gerbil_jaguar
+ih meerkat_panda_squirrel_vulture_wolf
+reverse
+rht bear
+rht meerkat_panda_squirrel_vulture_wolf
+size
+free
+option layout 2
+new
+it bear
+it aardvark_bear_dolphin_gerbil_jaguar
+ih dolphin 3
+it bear
+rht dolphin
+rhtq
+rht dolphin
+rht bear
+rht aardvark_bear_dolphin_gerbil_jaguar
+ih meerkat_panda_squirrel_vulture_wolf
+reverse
+rht bear
+rht meerkat_panda_squirrel_vulture_wolf
+size
+free
+option layout 3
+new
+it bear
+it aardvark_bear_dolphin_gerbil_jaguar
+ih dolphin 3
+it bear
+rht dolphin
+rhtq
+rht dolphin
+rht bear
+rht aardvark_bear_dolphin_gerbil_jaguar
+ih meerkat_panda_squirrel_vulture_wolf
+reverse
+rht bear
+rht meerkat_panda_squirrel_vulture_wolf
+size
+free
+option layout 4
+new
+it bear
+it aardvark_bear_dolphin_gerbil_jaguar
+ih dolphin 3
+it bear
+rht dolphin
+rhtq
+rht dolphin
+rht bear
+rht aardvark_bear_dolphin_gerbil_jaguar
+ih meerkat_panda_squirrel_vulture_wolf
+reverse
+rht bear
+rht meerkat_panda_squirrel_vulture_wolf
+size
+free
+option layout 0
+option backend 2
+new
+ih dolphin
+it aardvark_bear_dolphin_gerbil_jaguar
+rht dolphin
+rht aardvark_bear_dolphin_gerbil_jaguar
+free
+option layout 0
+option backend 4
+new
+ih dolphin
+it aardvark_bear_dolphin_gerbil_jaguar
+rht dolphin
+rht aardvark_bear_dolphin_gerbil_jaguar
+free
@@ -0,0 +1,131 @@
+# Test of inserting and removing strings in batches
+option fail 0
+option malloc 0
+option layout 0
+new
+ih bear 100
+ih dolphin 100
+it gerbil 100
+ih aardvark
+it meerkat
+nth 0 aardvark
+nth 1 dolphin
+nth 101 bear
+nth 201 gerbil
+rhq 101
+rh bear
+rt meerkat
+rhq 199
+size
+ih RAND 50
+it squirrel
+rhq 50
+rh squirrel
+free
+option layout 2
+new
+ih bear 100
+ih dolphin 100
+it gerbil 100
+ih aardvark
+it meerkat
+nth 0 aardvark
+nth 1 dolphin
+nth 101 bear
+nth 201 gerbil
+rhq 101
+rh bear
+rt meerkat
+rhq 199
+size
+ih RAND 50
+it squirrel
+rhq 50
+rh squirrel
+free
+option layout 4
+new
+ih bear 100
+ih dolphin 100
+it gerbil 100
+ih aardvark
+it meerkat
+nth 0 aardvark
+nth 1 dolphin
+nth 101 bear
+nth 201 gerbil
+rhq 101
+rh bear
+rt meerkat
+rhq 199
+size
+ih RAND 50
+it squirrel
+rhq 50
+rh squirrel
+free
+option layout 0
+option backend 1
+new
+it bear 40
+ih aardvark
+it dolphin 40
+rhq 40
+nth 0 bear
+nth 40 dolphin
+rh bear
+rhq 39
+rh dolphin
+free
+option layout 0
+option backend 2
+new
+it bear 40
+ih aardvark
+it dolphin 40
+rhq 40
+nth 0 bear
+nth 40 dolphin
+rh bear
+rhq 39
+rh dolphin
+free
+option layout 0
+option backend 3
+new
+it bear 40
+ih aardvark
+it dolphin 40
+rhq 40
+nth 0 bear
+nth 40 dolphin
+rh bear
+rhq 39
+rh dolphin
+free
+option layout 0
+option backend 4
+new
+it bear 40
+ih aardvark
+it dolphin 40
+rhq 40
+nth 0 bear
+nth 40 dolphin
+rh bear
+rhq 39
+rh dolphin
+free
+option layout 0
+option backend 6
+new
+it bear 40
+ih aardvark
+it dolphin 40
+rhq 40
+nth 0 bear
+nth 40 dolphin
+rh bear
+rhq 39
+rh dolphin
+free
@@ -0,0 +1,172 @@
+# Test of concat and split between named queues on every backend, and of
+# freeing queues that share their allocators
+option fail 0
+option malloc 0
+option backend 0
+queue main
+new
+it bear
+it dolphin
+it gerbil
+queue other
+new
+it meerkat
+it squirrel
+it vulture
+queue main
+concat other
+size
+split 2 other
+rh bear
+rh dolphin
+size
+queue other
+rh gerbil
+rh meerkat
+rh squirrel
+rh vulture
+free
+queue main
+free
+option backend 1
+queue main
+new
+it bear
+it dolphin
+it gerbil
+queue other
+new
+it meerkat
+it squirrel
+it vulture
+queue main
+concat other
+size
+split 2 other
+rh bear
+rh dolphin
+size
+queue other
+rh gerbil
+rh meerkat
+rh squirrel
+rh vulture
+free
+queue main
+free
+option backend 2
+queue main
+new
+it bear
+it dolphin
+it gerbil
+queue other
+new
+it meerkat
+it squirrel
+it vulture
+queue main
+concat other
+size
+split 2 other
+rh bear
+rh dolphin
+size
+queue other
+rh gerbil
+rh meerkat
+rh squirrel
+rh vulture
+free
+queue main
+free
+option backend 3
+queue main
+new
+it bear
+it dolphin
+it gerbil
+queue other
+new
+it meerkat
+it squirrel
+it vulture
+queue main
+concat other
+size
+split 2 other
+rh bear
+rh dolphin
+size
+queue other
+rh gerbil
+rh meerkat
+rh squirrel
+rh vulture
+free
+queue main
+free
+option backend 4
+queue main
+new
+it bear
+it dolphin
+it gerbil
+queue other
+new
+it meerkat
+it squirrel
+it vulture
+queue main
+concat other
+size
+split 2 other
+rh bear
+rh dolphin
+size
+queue other
+rh gerbil
+rh meerkat
+rh squirrel
+rh vulture
+free
+queue main
+free
+option backend 6
+queue main
+new
+it vulture
+it bear
+queue other
+new
+it gerbil
+it dolphin
+queue main
+concat other
+split 1 other
+rh bear
+queue other
+rh dolphin
+rh gerbil
+rh vulture
+free
+queue main
+free
+option backend 0
+option layout 4
+queue main
+new
+it bear 10
+queue other
+new
+it dolphin 10
+queue main
+concat other
+split 15 other
+rt dolphin
+rh bear
+free
+queue other
+rh dolphin
+rhq 4
+free
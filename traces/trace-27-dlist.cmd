@@ -0,0 +1,56 @@
+# Test of the doubly linked list, whose reverse only flips which end is the head
+option fail 0
+option malloc 0
+option backend 3
+new
+it bear
+it dolphin
+it gerbil
+rt gerbil
+it gerbil
+# Inserting and removing at either end after a reverse
+reverse
+ih meerkat
+it aardvark
+nth 0 meerkat
+nth 1 gerbil
+nth 4 aardvark
+rt aardvark
+rh meerkat
+rt bear
+reverse
+reverse
+rh gerbil
+rt dolphin
+# Sorting a reversed list puts it back the right way first
+it bear
+it squirrel
+it gerbil
+it aardvark
+reverse
+sort
+nth 0 aardvark
+rt squirrel
+reverse
+rh gerbil
+rt aardvark
+# Concat between lists running opposite ways
+queue other
+new
+it meerkat
+it vulture
+it zebra
+queue main
+concat other
+nth 0 bear
+nth 1 meerkat
+rt zebra
+reverse
+split 1 other
+rh vulture
+queue other
+rh meerkat
+rh bear
+free
+queue main
+free
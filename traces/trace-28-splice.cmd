@@ -0,0 +1,65 @@
+# Test of splicing doubly linked lists, and sorting them with list_sort
+option fail 0
+option malloc 0
+option backend 3
+new
+it bear 10
+it dolphin 10
+it gerbil 10
+queue other
+new
+# Cut near the tail, then near the head, of the list
+queue main
+split 25 other
+split 5 other
+size
+queue other
+nth 0 gerbil
+nth 4 gerbil
+nth 5 bear
+nth 10 dolphin
+nth 20 gerbil
+rhq 25
+size
+# Splice back at the head of a reversed list, then at its tail
+it vulture
+it meerkat
+reverse
+queue main
+concat other
+nth 4 bear
+nth 5 meerkat
+rt vulture
+reverse
+queue other
+it aardvark
+queue main
+concat other
+rh meerkat
+rt aardvark
+rhq 5
+# list_sort over runs of repeated strings
+it vulture 100
+ih bear 100
+it dolphin 100
+ih squirrel 100
+it aardvark 50
+sort 3
+nth 0 aardvark
+nth 49 aardvark
+nth 50 bear
+nth 150 dolphin
+nth 250 squirrel
+nth 350 vulture
+reverse
+it zebra
+ih gerbil
+sort 3
+nth 0 aardvark
+nth 250 gerbil
+nth 251 squirrel
+rt zebra
+rt vulture
+free
+queue other
+free
@@ -0,0 +1,43 @@
+# Test of the compact backend reclaiming the heap bytes of removed strings
+option fail 0
+option malloc 0
+option backend 4
+new
+it dolphin 100
+stat dead 0
+rhq 90
+rt dolphin
+stat dead 728
+# The heap runs out of room, and is rebuilt with the live strings only
+it gerbil 40
+stat dead 0
+nth 0 dolphin
+nth 8 dolphin
+nth 9 gerbil
+nth 48 gerbil
+rh dolphin
+stat dead 8
+# Nodes of removed strings are reused
+rt gerbil
+ih meerkat
+it bear
+reverse
+rh bear
+rt meerkat
+sort
+rh dolphin
+rt gerbil
+# Concat copies the strings into the other heap, leaving this one empty
+queue other
+new
+it aardvark
+concat main
+stat dead 0
+rh aardvark
+rhq 7
+rh gerbil
+free
+queue main
+size
+stat dead 0
+free
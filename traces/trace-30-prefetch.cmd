@@ -0,0 +1,61 @@
+# Test of walks, reverse, sorts, relayout and free with prefetch hints
+option fail 0
+option malloc 0
+option prefetch 1
+option layout 0
+new
+ih dolphin 300
+it bear 300
+ih gerbil 300
+it aardvark
+reverse
+rh aardvark
+rt gerbil
+sort
+nth 0 bear
+nth 300 dolphin
+nth 599 dolphin
+nth 600 gerbil
+option prefetch 0
+reverse
+option prefetch 1
+relayout
+rh gerbil
+rt bear
+sort 3
+rh bear
+rt gerbil
+reverse
+relayout
+sort
+rh bear
+free
+option layout 2
+new
+ih dolphin 300
+it bear 300
+ih gerbil 300
+it aardvark
+reverse
+rh aardvark
+rt gerbil
+sort
+nth 0 bear
+nth 300 dolphin
+nth 599 dolphin
+nth 600 gerbil
+option prefetch 0
+reverse
+option prefetch 1
+relayout
+rh gerbil
+rt bear
+sort 3
+rh bear
+rt gerbil
+reverse
+relayout
+sort
+rh bear
+free
+option prefetch 0
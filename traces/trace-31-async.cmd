@@ -0,0 +1,54 @@
+# Test of releasing large queues in the background
+option fail 0
+option malloc 0
+option async 1
+option layout 0
+new
+ih dolphin 200000
+it gerbil 200000
+free
+# Keep allocating while the reclaimer frees the old queue
+new
+ih bear 200000
+it meerkat
+rh bear
+rt meerkat
+queue other
+new
+it squirrel 2000
+free
+queue main
+free
+option layout 4
+new
+ih dolphin 200000
+it gerbil 200000
+free
+# Keep allocating while the reclaimer frees the old queue
+new
+ih bear 200000
+it meerkat
+rh bear
+rt meerkat
+queue other
+new
+it squirrel 2000
+free
+queue main
+free
+# Queues sharing interned strings are freed right away
+option layout 3
+new
+ih vulture 5000
+free
+stat references 0
+option layout 0
+option backend 2
+new
+it zebra 100000
+free
+new
+it aardvark 10
+stat blocks 14
+free
+option async 0
@@ -0,0 +1,48 @@
+# Test of small and large queues with chunks on huge pages
+option fail 0
+option malloc 0
+option hugepage 1
+# Small queues keep their chunks on malloc
+new
+ih dolphin 20
+queue arena
+option layout 4
+new
+ih gerbil 20
+queue dlist
+option backend 3
+new
+it bear 20
+queue unrolled
+option layout 0
+option backend 1
+new
+ih meerkat 20
+stat regions 0
+rh meerkat
+free
+queue dlist
+rt bear
+free
+queue arena
+free
+queue main
+free
+# Large queues grow their chunks until they fill a huge page
+option backend 0
+new
+ih lemur 200000
+stat regions 2
+queue arena
+option layout 4
+new
+it vulture 200000
+stat regions 5
+rh vulture
+free
+queue main
+rh lemur
+free
+stat regions 0
+option layout 0
+option hugepage 0
@@ -0,0 +1,56 @@
+# Test of snapshots, which must not change when their queue does
+option fail 0
+option malloc 0
+new
+it bear
+it dolphin
+it gerbil
+snap first
+snapshow first bear dolphin gerbil
+# Changes at either end share the elements with the snapshot
+rh bear
+snapshow first bear dolphin gerbil
+ih aardvark
+snapshow first bear dolphin gerbil
+it meerkat
+snapshow first bear dolphin gerbil
+snap second
+snap
+snapshow second aardvark dolphin gerbil meerkat
+# Other changes give the snapshots copies of their own first
+reverse
+snapshow first bear dolphin gerbil
+snapshow second aardvark dolphin gerbil meerkat
+rh meerkat
+snapdrop first
+rh gerbil
+snapshow second aardvark dolphin gerbil meerkat
+sort
+snapshow second aardvark dolphin gerbil meerkat
+snapdrop second
+rh aardvark
+rh dolphin
+free
+# Snapshots of other backends are copies from the start
+option backend 3
+new
+ih bear 3
+it gerbil
+snap third
+rhq 3
+ih zebra
+rt gerbil
+snapshow third bear bear bear gerbil
+snapdrop third
+free
+option backend 0
+option layout 3
+new
+it vulture 2
+ih lemur
+snap fourth
+rh lemur
+free
+snapshow fourth lemur vulture vulture
+snapdrop fourth
+option layout 0
@@ -0,0 +1,37 @@
+# Test of saving a queue to a file and loading it back
+option fail 0
+option malloc 0
+new
+it bear
+it dolphin
+it bear
+it gerbil
+save trace-34-persist.q
+rh bear
+rh dolphin
+load trace-34-persist.q
+size
+rh bear
+rh dolphin
+rh bear
+rh gerbil
+free
+# The layout and backend of the loaded queue are the current ones
+option layout 3
+option backend 1
+new
+ih vulture 30
+it squirrel
+save trace-34-persist.q
+free
+option layout 4
+option backend 3
+new
+load trace-34-persist.q
+rt squirrel
+rhq 29
+rh vulture
+free
+option layout 0
+option backend 0
+rm trace-34-persist.q
@@ -0,0 +1,43 @@
+# Test of importing the lines of a file, skipping empty ones
+option fail 0
+option malloc 0
+new
+ih aardvark
+import traces/trace-35-import.txt
+import traces/trace-35-import.txt head
+size
+rh meerkat
+rh gerbil
+rh bear
+rh dolphin
+rh aardvark
+rh dolphin
+rh bear
+rh gerbil
+rh meerkat
+free
+# Imported strings are interned like inserted ones
+option layout 3
+new
+import traces/trace-35-import.txt
+import traces/trace-35-import.txt
+stat references 8
+stat unique 4
+rt meerkat
+rt gerbil
+rt bear
+rt dolphin
+rhq 4
+free
+option layout 0
+option backend 2
+new
+it zebra
+import traces/trace-35-import.txt head
+rt zebra
+rh meerkat
+rt dolphin
+rh gerbil
+rh bear
+free
+option backend 0
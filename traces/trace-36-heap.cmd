@@ -0,0 +1,55 @@
+# Test of push and popmin on the heap backend
+option fail 0
+option malloc 0
+option backend 5
+new
+push gerbil
+push dolphin
+push vulture
+push bear 3
+# Inserting at either end pushes too
+it meerkat
+ih aardvark
+popmin aardvark
+popmin bear
+rh bear
+popmin bear
+popmin dolphin
+push squirrel
+popmin gerbil
+popmin meerkat
+popmin squirrel
+popmin vulture
+size
+# Growing past the first array keeps the order
+push zebra 300
+push lemur 300
+push bear 300
+popmin bear
+# A sorted heap is still a heap
+sort
+nth 0 bear
+nth 298 bear
+nth 299 lemur
+nth 598 lemur
+nth 599 zebra
+rt zebra
+push aardvark
+popmin aardvark
+popmin bear
+# Concatenating two heaps keeps them one
+queue other
+new
+push dolphin 2
+push aardvark
+queue main
+concat other
+popmin aardvark
+rhq 298
+popmin dolphin
+popmin dolphin
+popmin lemur
+free
+queue other
+free
+option backend 0
@@ -0,0 +1,54 @@
+# Test of nth, rank and range on the skip list backend
+option fail 0
+option malloc 0
+option backend 6
+new
+# Strings go to their sorted place wherever they are inserted
+ih meerkat
+it bear
+ih vulture
+it dolphin
+ih gerbil
+it bear
+nth 0 bear
+nth 1 bear
+nth 2 dolphin
+nth 3 gerbil
+nth 4 meerkat
+nth 5 vulture
+rank aardvark 0
+rank bear 0
+rank dolphin 2
+rank emu 3
+rank zebra 6
+range bear gerbil bear bear dolphin gerbil
+range cat meerkat dolphin gerbil meerkat
+range walrus zebra
+reverse
+sort
+nth 0 bear
+rh bear
+rt vulture
+nth 0 bear
+nth 2 gerbil
+rank gerbil 2
+range a z bear dolphin gerbil meerkat
+rh bear
+rh dolphin
+rh gerbil
+rh meerkat
+# Ranks stay right across many levels
+it lemur 500
+ih aardvark 300
+it zebra 200
+rank lemur 300
+rank zebra 800
+nth 299 aardvark
+nth 300 lemur
+nth 799 lemur
+nth 800 zebra
+range aardvark aardvark
+rhq 300
+rh lemur
+free
+option backend 0
@@ -0,0 +1,64 @@
+# Test of contains and count with the hash index
+option fail 0
+option malloc 0
+new
+it bear
+it dolphin
+index
+it bear
+ih gerbil 3
+count bear 2
+count gerbil 3
+count meerkat 0
+contains dolphin 1
+contains meerkat 0
+rh gerbil
+rt bear
+count bear 1
+count gerbil 2
+rht gerbil
+count gerbil 1
+reverse
+sort
+count gerbil 1
+# Moving elements between queues updates the index of both
+queue other
+new
+it bear
+it meerkat
+queue main
+concat other
+count bear 2
+count meerkat 1
+split 1 other
+count bear 1
+count meerkat 0
+contains dolphin 0
+queue other
+count dolphin 1
+count meerkat 1
+queue main
+index 0
+count bear 1
+count dolphin 0
+contains bear 1
+free
+queue other
+free
+queue main
+# Growing the index keeps every count
+option backend 2
+new
+index
+it bear 3000
+ih RAND 3000
+it dolphin
+count bear 3000
+count dolphin 1
+contains zebra 0
+rt dolphin
+contains dolphin 0
+rhq 3000
+count bear 3000
+free
+option backend 0
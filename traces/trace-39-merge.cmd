@@ -0,0 +1,90 @@
+# Test of the bottom-up merge sort on runs of uneven length
+option fail 0
+option malloc 0
+# One and two elements
+new
+it bear
+sort 0
+rt bear
+it gerbil
+ih zebra
+sort 0
+rh gerbil
+rt zebra
+# Reversed runs of uneven length, with the tail kept after sorting
+ih zebra 333
+ih meerkat 257
+ih dolphin 100
+ih bear 7
+it aardvark 3
+sort 0
+nth 0 aardvark
+nth 2 aardvark
+nth 3 bear
+nth 9 bear
+nth 10 dolphin
+nth 109 dolphin
+nth 110 meerkat
+nth 366 meerkat
+nth 367 zebra
+nth 699 zebra
+it zoo
+rt zoo
+rt zebra
+rh aardvark
+# Already sorted input
+sort 0
+nth 2 bear
+nth 697 zebra
+free
+# Every element layout, with strings too long to fit inline
+option layout 1
+new
+ih dolphin
+it a_string_too_long_to_fit_inline_in_a_small_element
+ih bear 3
+it gerbil
+reverse
+rht gerbil
+sort 0
+relayout
+rht a_string_too_long_to_fit_inline_in_a_small_element
+rh bear
+rht bear
+rt dolphin
+rh bear
+free
+option layout 2
+new
+it zebra 50
+it a_string_too_long_to_fit_inline_in_a_small_element 50
+ih bear 50
+sort 0
+nth 49 a_string_too_long_to_fit_inline_in_a_small_element
+nth 50 bear
+nth 100 zebra
+rt zebra
+free
+option layout 3
+new
+it zebra 50
+ih gerbil 50
+it bear 50
+sort 0
+nth 49 bear
+nth 50 gerbil
+nth 149 zebra
+rt zebra
+free
+option layout 4
+new
+it zebra 50
+ih gerbil 50
+it bear 50
+sort 0
+relayout
+nth 0 bear
+nth 99 gerbil
+rt zebra
+free
+option layout 0
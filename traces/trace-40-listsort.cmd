@@ -0,0 +1,65 @@
+# Test of list_sort on the linked list and the doubly linked list
+option fail 0
+option malloc 0
+new
+it bear
+sort 3
+rt bear
+it gerbil
+ih zebra
+sort 3
+rh gerbil
+rt zebra
+# Sizes around powers of two, where the pending merges differ
+ih zebra 256
+ih meerkat 257
+ih dolphin 192
+ih bear 1
+sort 3
+nth 0 bear
+nth 1 dolphin
+nth 192 dolphin
+nth 193 meerkat
+nth 449 meerkat
+nth 450 zebra
+nth 705 zebra
+it zoo
+rt zoo
+rt zebra
+rh bear
+sort 3
+nth 0 dolphin
+nth 703 zebra
+free
+# The doubly linked list sorts with the kernel list_sort
+option backend 3
+new
+it zebra 300
+it meerkat 129
+ih dolphin 64
+it bear 65
+sort
+nth 0 bear
+nth 64 bear
+nth 65 dolphin
+nth 128 dolphin
+nth 129 meerkat
+nth 257 meerkat
+nth 258 zebra
+rt zebra
+rh bear
+# Sorting after reverse orders the list as seen from the head
+reverse
+it aardvark
+ih zoo
+sort
+rh aardvark
+rt zoo
+nth 0 bear
+nth 63 bear
+nth 555 zebra
+reverse
+rh zebra
+rt bear
+free
+option backend 0
@@ -0,0 +1,426 @@
+/*
+ * Unrolled linked-list backend.
+ *
+ * Strings are kept in blocks of UNROLLED_K pointers, so walking the queue
+ * touches one block header per UNROLLED_K elements instead of one list
+ * element per string.  Blocks are doubly linked, which lets the sort move
+ * cursors in both directions.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "backend.h"
+#include "harness.h"
+
+/* Number of string pointers in each block */
+#define UNROLLED_K 32
+
+typedef struct BLOCK {
+    struct BLOCK *next, *prev;
+    int start; /* Index of the first used slot */
+    int count; /* Number of used slots, which are contiguous */
+    char *values[UNROLLED_K];
+} block_t;
+
+typedef struct {
+    block_t *first;
+    block_t *last;
+} unrolled_t;
+
+/* Position of one string, used by the walk and by the sort */
+typedef struct {
+    block_t *b;
+    int i;
+} cursor_t;
+
+#define CURSOR_VALUE(c) ((c).b->values[(c).i])
+
+static inline void swap_value(char **a, char **b)
+{
+    char *tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+static void cursor_next(cursor_t *c)
+{
+    if (++c->i == c->b->start + c->b->count) {
+        c->b = c->b->next;
+        if (c->b)
+            c->i = c->b->start;
+    }
+}
+
+static void cursor_prev(cursor_t *c)
+{
+    if (c->i-- == c->b->start) {
+        c->b = c->b->prev;
+        if (c->b)
+            c->i = c->b->start + c->b->count - 1;
+    }
+}
+
+static bool unrolled_init(queue_t *q)
+{
+    unrolled_t *u = malloc(sizeof(unrolled_t));
+    if (!u)
+        return false;
+    if (!pool_init(&q->mem->pool, sizeof(block_t))) {
+        free(u);
+        return false;
+    }
+
+    u->first = NULL;
+    u->last = NULL;
+    q->store = u;
+    return true;
+}
+
+static void unrolled_release(queue_t *q)
+{
+    unrolled_t *u = q->store;
+
+    for (block_t *b = u->first; b;) {
+        block_t *next = b->next;
+        for (int i = b->start; i < b->start + b->count; i++)
+            free(b->values[i]);
+        /* The pool may be shared with other queues, see q_concat() */
+        pool_free(&q->mem->pool, b);
+        b = next;
+    }
+
+    free(u);
+}
+
+static bool unrolled_insert_head(queue_t *q, const char *s, size_t len)
+{
+    unrolled_t *u = q->store;
+    block_t *b = u->first;
+
+    char *value = backend_copy_string(s, len);
+    if (!value)
+        return false;
+
+    if (!b || b->count == UNROLLED_K) {
+        b = pool_alloc(&q->mem->pool);
+        if (!b) {
+            free(value);
+            return false;
+        }
+        /* Fill the new block from its end, so later heads fit before */
+        b->start = UNROLLED_K;
+        b->count = 0;
+        b->prev = NULL;
+        b->next = u->first;
+        if (u->first)
+            u->first->prev = b;
+        else
+            u->last = b;
+        u->first = b;
+    } else if (b->start == 0) {
+        /* Room left at the end only, slide the strings over */
+        int shift = UNROLLED_K - b->count;
+        memmove(b->values + shift, b->values, b->count * sizeof(char *));
+        b->start = shift;
+    }
+
+    b->values[--b->start] = value;
+    b->count++;
+    q->size++;
+    return true;
+}
+
+static bool unrolled_insert_tail(queue_t *q, const char *s, size_t len)
+{
+    unrolled_t *u = q->store;
+    block_t *b = u->last;
+
+    char *value = backend_copy_string(s, len);
+    if (!value)
+        return false;
+
+    if (!b || b->count == UNROLLED_K) {
+        b = pool_alloc(&q->mem->pool);
+        if (!b) {
+            free(value);
+            return false;
+        }
+        b->start = 0;
+        b->count = 0;
+        b->next = NULL;
+        b->prev = u->last;
+        if (u->last)
+            u->last->next = b;
+        else
+            u->first = b;
+        u->last = b;
+    } else if (b->start + b->count == UNROLLED_K) {
+        /* Room left at the front only, slide the strings over */
+        memmove(b->values, b->values + b->start, b->count * sizeof(char *));
+        b->start = 0;
+    }
+
+    b->values[b->start + b->count++] = value;
+    q->size++;
+    return true;
+}
+
+static char *unrolled_take_head(queue_t *q)
+{
+    unrolled_t *u = q->store;
+    block_t *b = u->first;
+    char *value = b->values[b->start];
+
+    b->start++;
+    if (!--b->count) {
+        u->first = b->next;
+        if (u->first)
+            u->first->prev = NULL;
+        else
+            u->last = NULL;
+        pool_free(&q->mem->pool, b);
+    }
+
+    q->size--;
+    return value;
+}
+
+static char *unrolled_take_tail(queue_t *q)
+{
+    unrolled_t *u = q->store;
+    block_t *b = u->last;
+    char *value = b->values[b->start + b->count - 1];
+
+    if (!--b->count) {
+        u->last = b->prev;
+        if (u->last)
+            u->last->next = NULL;
+        else
+            u->first = NULL;
+        pool_free(&q->mem->pool, b);
+    }
+
+    q->size--;
+    return value;
+}
+
+static char *unrolled_peek_head(queue_t *q)
+{
+    unrolled_t *u = q->store;
+    return u->first->values[u->first->start];
+}
+
+static void unrolled_reverse(queue_t *q)
+{
+    unrolled_t *u = q->store;
+
+    for (block_t *b = u->first; b; b = b->prev) {
+        /* Reverse the strings inside the block */
+        char **lo = b->values + b->start;
+        char **hi = lo + b->count - 1;
+        for (; lo < hi; lo++, hi--)
+            swap_value(lo, hi);
+
+        /* Then the direction of the block, b->prev is the old next */
+        block_t *tmp = b->next;
+        b->next = b->prev;
+        b->prev = tmp;
+    }
+
+    block_t *tmp = u->first;
+    u->first = u->last;
+    u->last = tmp;
+}
+
+/* Link the blocks from first to last after the last block of queue q */
+static void append_blocks(queue_t *q, block_t *first, block_t *last)
+{
+    unrolled_t *u = q->store;
+
+    first->prev = u->last;
+    if (u->last)
+        u->last->next = first;
+    else
+        u->first = first;
+    u->last = last;
+}
+
+static bool unrolled_concat(queue_t *dst, queue_t *src)
+{
+    unrolled_t *s = src->store;
+
+    append_blocks(dst, s->first, s->last);
+    dst->size += src->size;
+
+    s->first = NULL;
+    s->last = NULL;
+    src->size = 0;
+    return true;
+}
+
+static bool unrolled_split(queue_t *q, int n, queue_t *out)
+{
+    unrolled_t *u = q->store;
+
+    /* Find the block holding the first string to move */
+    block_t *b = u->first;
+    int skip = n;
+    while (skip >= b->count) {
+        skip -= b->count;
+        b = b->next;
+    }
+
+    /* Strings of b past the cut move to a block of their own */
+    block_t *first = b;
+    if (skip) {
+        first = pool_alloc(&q->mem->pool);
+        if (!first)
+            return false;
+        first->start = 0;
+        first->count = b->count - skip;
+        memcpy(first->values, b->values + b->start + skip,
+               first->count * sizeof(char *));
+        b->count = skip;
+
+        first->next = b->next;
+        if (b->next)
+            b->next->prev = first;
+        else
+            u->last = first;
+        b->next = first;
+        first->prev = b;
+    }
+
+    block_t *last = u->last;
+    u->last = first->prev;
+    if (u->last)
+        u->last->next = NULL;
+    else
+        u->first = NULL;
+
+    append_blocks(out, first, last);
+    out->size += q->size - n;
+    q->size = n;
+    return true;
+}
+
+/*
+ * Quick sort of the n strings from lo to hi, swapping pointers in place so
+ * no memory is allocated.  Blocks are never split or merged.
+ * The smaller partition is sorted recursively and the larger one in the
+ * loop, bounding the depth of recursion to O(log n).
+ */
+static void quick_sort(cursor_t lo, cursor_t hi, int n)
+{
+    while (n > 1) {
+        /* Median of first, middle and last string becomes the pivot */
+        cursor_t mid = lo;
+        for (int k = 0; k < n / 2; k++)
+            cursor_next(&mid);
+
+        char **a = &CURSOR_VALUE(lo), **m = &CURSOR_VALUE(mid);
+        char **z = &CURSOR_VALUE(hi);
+        if (strcmp(*m, *a) < 0)
+            swap_value(m, a);
+        if (strcmp(*z, *m) < 0) {
+            swap_value(z, m);
+            if (strcmp(*m, *a) < 0)
+                swap_value(m, a);
+        }
+        swap_value(m, a);
+        char *pivot = *a;
+
+        /*
+         * Partition around the pivot kept at lo.  i and j stop on strings
+         * equal to the pivot, which keeps duplicates evenly split.
+         * j starts one past hi, which no cursor can express, so the
+         * first step of j only moves its logical index.
+         */
+        cursor_t i = lo, j = hi;
+        int li = 0, lj = n;
+        for (;;) {
+            do {
+                cursor_next(&i);
+                li++;
+            } while (li < n - 1 && strcmp(CURSOR_VALUE(i), pivot) < 0);
+
+            do {
+                if (lj-- != n)
+                    cursor_prev(&j);
+            } while (lj > 0 && strcmp(pivot, CURSOR_VALUE(j)) < 0);
+
+            if (li >= lj)
+                break;
+            swap_value(&CURSOR_VALUE(i), &CURSOR_VALUE(j));
+        }
+        CURSOR_VALUE(lo) = CURSOR_VALUE(j);
+        CURSOR_VALUE(j) = pivot;
+
+        /* Pivot is final at j: [lo, j) has lj strings, (j, hi] the rest */
+        int left_n = lj, right_n = n - lj - 1;
+        cursor_t left_hi = j, right_lo = j;
+        if (left_n)
+            cursor_prev(&left_hi);
+        if (right_n)
+            cursor_next(&right_lo);
+
+        if (left_n < right_n) {
+            quick_sort(lo, left_hi, left_n);
+            lo = right_lo;
+            n = right_n;
+        } else {
+            quick_sort(right_lo, hi, right_n);
+            hi = left_hi;
+            n = left_n;
+        }
+    }
+}
+
+static void unrolled_sort(queue_t *q)
+{
+    unrolled_t *u = q->store;
+    cursor_t lo = {u->first, u->first->start};
+    cursor_t hi = {u->last, u->last->start + u->last->count - 1};
+
+    quick_sort(lo, hi, q->size);
+}
+
+static void unrolled_iter_init(q_iter_t *it)
+{
+    unrolled_t *u = it->q->store;
+
+    it->node = u->first;
+    if (u->first)
+        it->index = u->first->start;
+}
+
+static char *unrolled_iter_next(q_iter_t *it)
+{
+    cursor_t c = {it->node, it->index};
+
+    if (!c.b)
+        return NULL;
+
+    char *value = CURSOR_VALUE(c);
+    cursor_next(&c);
+    it->node = c.b;
+    it->index = c.i;
+    return value;
+}
+
+const backend_t unrolled_backend = {
+    .init = unrolled_init,
+    .release = unrolled_release,
+    .insert_head = unrolled_insert_head,
+    .insert_tail = unrolled_insert_tail,
+    .take_head = unrolled_take_head,
+    .take_tail = unrolled_take_tail,
+    .peek_head = unrolled_peek_head,
+    .reverse = unrolled_reverse,
+    .sort = unrolled_sort,
+    .concat = unrolled_concat,
+    .split = unrolled_split,
+    .iter_init = unrolled_iter_init,
+    .iter_next = unrolled_iter_next,
+};